@@ -1,6 +1,8 @@
 #pragma once
 
 #include <tuple>
+#include <cstddef>
+#include <cassert>
 #include "subscription_list.h"
 
 namespace snw {
@@ -0,0 +1,137 @@
+#include "buddy_allocator.h"
+#include "bits.h"
+#include "align.h"
+#include <algorithm>
+#include <stdexcept>
+
+constexpr int snw::buddy_allocator::max_order;
+constexpr size_t snw::buddy_allocator::max_span_size;
+
+snw::buddy_allocator::buddy_allocator(page* first, size_t page_count)
+    : base_(first)
+    , capacity_(page_count)
+    , size_(0)
+{
+    for (int order = 0; order <= max_order; ++order) {
+        size_t block_count = (capacity_ >> order) + 1;
+        free_maps_[order].words.resize(align_up(block_count, 64) / 64, 0);
+        free_maps_[order].hint = 0;
+    }
+
+    // carve the region into the largest aligned blocks that fit
+    size_t offset = 0;
+    while (offset < capacity_) {
+        int order = max_order;
+        while ((order > 0) && (!is_aligned(offset, static_cast<size_t>(1) << order) || ((offset + (static_cast<size_t>(1) << order)) > capacity_))) {
+            --order;
+        }
+
+        insert(order, offset >> order);
+        offset += static_cast<size_t>(1) << order;
+    }
+}
+
+snw::buddy_allocator::~buddy_allocator() {
+    assert(size_ == 0 && "leaked spans");
+}
+
+snw::page* snw::buddy_allocator::allocate(size_t page_count) {
+    int order = order_of(page_count);
+    if (order > max_order) {
+        return nullptr;
+    }
+
+    // find the smallest order with a free block, preferring lower addresses
+    int block_order = order;
+    size_t index = 0;
+    for (; block_order <= max_order; ++block_order) {
+        if (find(block_order, &index)) {
+            break;
+        }
+    }
+    if (block_order > max_order) {
+        return nullptr;
+    }
+
+    bool removed = remove(block_order, index);
+    assert(removed);
+    (void)removed;
+
+    // split it down to size, freeing the upper halves
+    while (block_order > order) {
+        --block_order;
+        index <<= 1;
+        insert(block_order, index + 1);
+    }
+
+    size_ += static_cast<size_t>(1) << order;
+    return base_ + (index << order);
+}
+
+void snw::buddy_allocator::deallocate(page* first, size_t page_count) {
+    assert(owns(first));
+
+    int order = order_of(page_count);
+    assert(order <= max_order);
+
+    size_t offset = first - base_;
+    assert(is_aligned(offset, static_cast<size_t>(1) << order));
+
+    size_ -= static_cast<size_t>(1) << order;
+
+    // merge with free buddies
+    size_t index = offset >> order;
+    while ((order < max_order) && remove(order, index ^ 1)) {
+        index >>= 1;
+        ++order;
+    }
+
+    insert(order, index);
+}
+
+size_t snw::buddy_allocator::span_size(size_t page_count) {
+    return static_cast<size_t>(1) << order_of(page_count);
+}
+
+int snw::buddy_allocator::order_of(size_t page_count) {
+    int order = 0;
+    while ((static_cast<size_t>(1) << order) < page_count) {
+        ++order;
+    }
+
+    return order;
+}
+
+void snw::buddy_allocator::insert(int order, size_t index) {
+    free_map& map = free_maps_[order];
+
+    size_t word = index / 64;
+    assert(!test_bit(map.words[word], index % 64));
+    set_bit(map.words[word], index % 64);
+    map.hint = std::min(map.hint, word);
+}
+
+bool snw::buddy_allocator::remove(int order, size_t index) {
+    free_map& map = free_maps_[order];
+
+    size_t word = index / 64;
+    if ((word >= map.words.size()) || !test_bit(map.words[word], index % 64)) {
+        return false;
+    }
+
+    clear_bit(map.words[word], index % 64);
+    return true;
+}
+
+bool snw::buddy_allocator::find(int order, size_t* index) {
+    free_map& map = free_maps_[order];
+
+    for (; map.hint < map.words.size(); ++map.hint) {
+        if (uint64_t word = map.words[map.hint]) {
+            *index = (map.hint * 64) + count_trailing_zeros(word);
+            return true;
+        }
+    }
+
+    return false;
+}
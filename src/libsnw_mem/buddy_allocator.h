@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <cassert>
+#include "types.h"
+#include "page.h"
+
+namespace snw {
+
+// Manages power of 2 sized spans of contiguous pages (from 1 to
+// max_span_size pages) inside a region of pages. Spans are naturally
+// aligned relative to the start of the region, the lowest addressed free
+// span is always preferred, and freed spans are eagerly coalesced with
+// their buddies to keep fragmentation bounded.
+//
+// The free state is kept in per-order bitmaps outside of the region, so
+// free pages are never touched (and never faulted in) by the allocator.
+class buddy_allocator {
+public:
+    static constexpr int    max_order = 9;
+    static constexpr size_t max_span_size = static_cast<size_t>(1) << max_order;
+
+    buddy_allocator(page* first, size_t page_count);
+    buddy_allocator(buddy_allocator&&) = delete;
+    buddy_allocator(const buddy_allocator&) = delete;
+    ~buddy_allocator();
+
+    buddy_allocator& operator=(buddy_allocator&&) = delete;
+    buddy_allocator& operator=(const buddy_allocator&) = delete;
+
+    // Allocate a span of at least page_count contiguous pages (rounded up
+    // to a power of 2). Returns nullptr if there isn't a large enough span.
+    page* allocate(size_t page_count);
+
+    // Free a span. page_count must match the one used to allocate it.
+    void deallocate(page* first, size_t page_count);
+
+    bool owns(const page* page) const {
+        return (base_ <= page) && (page < (base_ + capacity_));
+    }
+
+    // number of allocated pages (including rounding)
+    size_t size() const {
+        return size_;
+    }
+
+    // number of managed pages
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    // the number of pages that allocate(page_count) will actually reserve
+    static size_t span_size(size_t page_count);
+
+private:
+    static int order_of(size_t page_count);
+
+    void insert(int order, size_t index);
+    bool remove(int order, size_t index);
+    bool find(int order, size_t* index);
+
+private:
+    struct free_map {
+        std::vector<uint64_t> words;
+        size_t                hint; // no free blocks before this word
+    };
+
+    page*    base_;
+    size_t   capacity_;
+    size_t   size_;
+    free_map free_maps_[max_order + 1];
+};
+
+}
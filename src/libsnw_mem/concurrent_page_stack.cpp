@@ -0,0 +1,48 @@
+#include "concurrent_page_stack.h"
+
+snw::concurrent_page_stack::concurrent_page_stack()
+    : head_(0)
+    , size_(0)
+{
+}
+
+snw::concurrent_page_stack::~concurrent_page_stack() {
+    assert(empty());
+}
+
+void snw::concurrent_page_stack::push_node(page* page) {
+    auto node = reinterpret_cast<concurrent_page_stack::node*>(page);
+    assert(!node->header.prev);
+    assert((reinterpret_cast<uintptr_t>(node) & ~address_mask) == 0);
+
+    // count before publishing so that size() never underflows
+    size_.fetch_add(page_stack::node_size(page), std::memory_order_relaxed);
+
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    uint64_t new_head;
+    do {
+        node->header.prev = decode(head);
+        new_head = encode(node, next_tag(head));
+    } while (!head_.compare_exchange_weak(head, new_head, std::memory_order_release, std::memory_order_relaxed));
+}
+
+snw::page* snw::concurrent_page_stack::pop_node() {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    for (;;) {
+        node* node = decode(head);
+        if (!node) {
+            return nullptr;
+        }
+
+        // this can race with the node being popped and reused by another
+        // thread, but then the tag will have changed and the exchange fails
+        uint64_t new_head = encode(node->header.prev, next_tag(head));
+        if (head_.compare_exchange_weak(head, new_head, std::memory_order_acquire, std::memory_order_acquire)) {
+            node->header.prev = nullptr;
+
+            auto page = reinterpret_cast<snw::page*>(node);
+            size_.fetch_sub(page_stack::node_size(page), std::memory_order_relaxed);
+            return page;
+        }
+    }
+}
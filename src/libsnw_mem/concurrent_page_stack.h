@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include "types.h"
+#include "page.h"
+#include "page_stack.h"
+
+namespace snw {
+
+// A lock-free (Treiber) stack of page_stack nodes, linked through
+// node_header::prev. The head pointer is tagged with a 16 bit version in
+// the unused upper address bits to avoid ABA when a node is popped and
+// pushed back while another thread is mid-pop.
+//
+// Node memory must stay mapped while the stack is in use, since a racing
+// pop may read the prev pointer of a node that was just popped (the CAS
+// then fails because the version changed).
+class concurrent_page_stack {
+public:
+    concurrent_page_stack();
+    concurrent_page_stack(concurrent_page_stack&&) = delete;
+    concurrent_page_stack(const concurrent_page_stack&) = delete;
+    ~concurrent_page_stack();
+
+    concurrent_page_stack& operator=(concurrent_page_stack&&) = delete;
+    concurrent_page_stack& operator=(const concurrent_page_stack&) = delete;
+
+    bool empty() const {
+        return !decode(head_.load(std::memory_order_acquire));
+    }
+
+    // approximate number of pages in the stack
+    size_t size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    // Push a node returned by page_stack::detach_node.
+    void push_node(page* page);
+
+    // Pop a node that can be handed to page_stack::attach_node. Returns
+    // nullptr if the stack is empty.
+    page* pop_node();
+
+private:
+    using node = page_stack::node;
+
+    static constexpr int      address_bits = 48;
+    static constexpr uint64_t address_mask = (static_cast<uint64_t>(1) << address_bits) - 1;
+
+    static uint64_t encode(node* node, uint64_t tag) {
+        uint64_t address = reinterpret_cast<uintptr_t>(node);
+        return (tag << address_bits) | (address & address_mask);
+    }
+
+    static node* decode(uint64_t value) {
+        return reinterpret_cast<node*>(static_cast<uintptr_t>(value & address_mask));
+    }
+
+    static uint64_t next_tag(uint64_t value) {
+        return (value >> address_bits) + 1;
+    }
+
+private:
+    std::atomic<uint64_t> head_;
+    uint8_t               pad0_[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<size_t>   size_;
+};
+
+}
@@ -0,0 +1,59 @@
+#include "numa_page_pool.h"
+#include <cassert>
+
+snw::numa_page_pool::numa_page_pool(size_t max_size_per_node, huge_page_mode mode, size_t trim_watermark) {
+    int node_count = get_numa_node_count();
+    arenas_.resize(node_count);
+
+    for (int i = 0; i < node_count; ++i) {
+        // with a single node there's nothing to bind to
+        numa_node_id numa_node = (node_count > 1) ? i : page_allocator::any_numa_node;
+
+        arenas_[i].allocator.reset(new page_allocator(max_size_per_node, mode, numa_node));
+        arenas_[i].pool.reset(new page_pool(*arenas_[i].allocator, trim_watermark));
+    }
+}
+
+snw::numa_page_pool::~numa_page_pool() {
+    // pools hand their pages back to the allocators
+    for (arena& arena: arenas_) {
+        arena.pool.reset();
+    }
+}
+
+snw::page_pool& snw::numa_page_pool::local() {
+    numa_node_id node = get_current_numa_node();
+    if ((node < 0) || (node >= node_count())) {
+        node = 0;
+    }
+
+    return *arenas_[node].pool;
+}
+
+snw::page_pool& snw::numa_page_pool::pool(numa_node_id node) {
+    assert((0 <= node) && (node < node_count()));
+    return *arenas_[node].pool;
+}
+
+snw::numa_node_id snw::numa_page_pool::node_of(const page* page) const {
+    for (size_t i = 0; i < arenas_.size(); ++i) {
+        if (arenas_[i].allocator->owns(page)) {
+            return static_cast<numa_node_id>(i);
+        }
+    }
+
+    return -1;
+}
+
+snw::numa_node_stats snw::numa_page_pool::stats(numa_node_id node) const {
+    assert((0 <= node) && (node < node_count()));
+
+    const arena& arena = arenas_[node];
+
+    numa_node_stats stats;
+    stats.capacity = arena.allocator->capacity();
+    stats.allocated = arena.pool->allocated();
+    stats.pooled = arena.pool->size();
+    stats.trimmed = arena.pool->trimmed();
+    return stats;
+}
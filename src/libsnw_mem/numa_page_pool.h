@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <limits>
+#include "types.h"
+#include "platform.h"
+#include "page_allocator.h"
+#include "page_pool.h"
+
+namespace snw {
+
+struct numa_node_stats {
+    size_t capacity;  // pages in the node's arena
+    size_t allocated; // pages handed out by the node's arena (including those pooled)
+    size_t pooled;    // approximate number of free pages in the node's pool
+    size_t trimmed;   // pages handed back to the kernel by the node's pool
+};
+
+// One page_allocator/page_pool pair per numa node, each arena bound to its
+// node. Threads get pages from their local node by default (a page_cache
+// should be built on top of local()), or from a specific node with pool().
+//
+// On systems without numa support this is a single node.
+class numa_page_pool {
+public:
+    numa_page_pool(size_t max_size_per_node, huge_page_mode mode = huge_page_mode::transparent, size_t trim_watermark = std::numeric_limits<size_t>::max());
+    numa_page_pool(numa_page_pool&&) = delete;
+    numa_page_pool(const numa_page_pool&) = delete;
+    ~numa_page_pool();
+
+    numa_page_pool& operator=(numa_page_pool&&) = delete;
+    numa_page_pool& operator=(const numa_page_pool&) = delete;
+
+    int node_count() const {
+        return static_cast<int>(arenas_.size());
+    }
+
+    // the pool of the node that the calling thread is running on
+    page_pool& local();
+
+    page_pool& pool(numa_node_id node);
+
+    // the node whose arena the page came from (-1 if none)
+    numa_node_id node_of(const page* page) const;
+
+    numa_node_stats stats(numa_node_id node) const;
+
+private:
+    struct arena {
+        std::unique_ptr<page_allocator> allocator;
+        std::unique_ptr<page_pool>      pool;
+    };
+
+    std::vector<arena> arenas_;
+};
+
+}
@@ -0,0 +1,403 @@
+#include "page_allocator.h"
+#include "align.h"
+#include "platform.h"
+#include <stdexcept>
+#include <cstdint>
+#include <cassert>
+
+#if defined(SNW_OS_UNIX)
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(SNW_OS_LINUX)
+#include <sys/syscall.h>
+#endif
+
+struct snw::page_allocator::file_header {
+    static constexpr uint64_t magic_value = 0x3145474150574e53; // "SNWPAGE1"
+    static constexpr uint32_t version_value = 1;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t page_size;
+    uint64_t capacity;
+    uint64_t root;
+    // followed by the bitmap of the pages in use
+};
+
+namespace {
+
+// Set the memory policy of [addr, addr + size) to prefer the given node.
+// This goes straight to the syscall to avoid a dependency on libnuma.
+bool bind_numa_node(void* addr, size_t size, snw::numa_node_id node) {
+#if defined(SNW_OS_LINUX) && defined(SYS_mbind)
+    static constexpr int mpol_preferred = 1; // MPOL_PREFERRED from <numaif.h>
+    static constexpr size_t bits_per_word = sizeof(unsigned long) * 8;
+    static constexpr size_t max_node_count = 1024;
+
+    if ((node < 0) || (static_cast<size_t>(node) >= max_node_count)) {
+        return false;
+    }
+
+    unsigned long node_mask[max_node_count / bits_per_word] = {};
+    node_mask[node / bits_per_word] |= 1UL << (node % bits_per_word);
+
+    return syscall(SYS_mbind, addr, size, mpol_preferred, node_mask, max_node_count + 1, 0) == 0;
+#else
+    return false;
+#endif
+}
+
+}
+
+snw::page_allocator::page_allocator(size_t max_size, huge_page_mode mode, numa_node_id numa_node)
+    : base_(nullptr)
+    , capacity_(0)
+    , brk_(0)
+    , size_(0)
+    , mode_(mode)
+    , numa_node_(any_numa_node)
+    , trim_watermark_(std::numeric_limits<size_t>::max())
+    , header_(nullptr)
+    , used_(nullptr)
+{
+    if (max_size == 0) {
+        throw std::runtime_error("bad page_allocator size");
+    }
+
+    // always reserve whole huge pages so the tail of the arena can be backed by one
+    size_t size = align_up(max_size, huge_page_size);
+    capacity_ = size / sizeof(page);
+
+    if (mode_ == huge_page_mode::explicit_) {
+#if defined(MAP_HUGETLB)
+        // hugetlb mappings are naturally aligned to the huge page size
+        void* addr = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE|MAP_HUGETLB, -1, 0);
+        if (addr == MAP_FAILED) {
+            throw std::runtime_error("failed create page_allocator - mmap hugetlb");
+        }
+
+        base_ = static_cast<page*>(addr);
+#else
+        throw std::runtime_error("failed create page_allocator - hugetlb not supported");
+#endif
+    }
+    else {
+        // over-reserve so that we can align the arena to a huge page boundary
+        size_t reserve_size = size + huge_page_size;
+        void* addr = mmap(nullptr, reserve_size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+        if (addr == MAP_FAILED) {
+            throw std::runtime_error("failed create page_allocator - mmap");
+        }
+
+        uint8_t* reserve_first = static_cast<uint8_t*>(addr);
+        uint8_t* reserve_last = reserve_first + reserve_size;
+        uint8_t* first = align_up(reserve_first, huge_page_size);
+        uint8_t* last = first + size;
+
+        // give back the slop on either side of the aligned arena
+        int rc;
+        if (reserve_first < first) {
+            rc = munmap(reserve_first, first - reserve_first);
+            assert(rc >= 0);
+        }
+        if (last < reserve_last) {
+            rc = munmap(last, reserve_last - last);
+            assert(rc >= 0);
+        }
+
+#if defined(MADV_HUGEPAGE)
+        if (mode_ == huge_page_mode::transparent) {
+            // this is only a hint; THP may be disabled system wide
+            madvise(first, size, MADV_HUGEPAGE);
+        }
+#endif
+
+        base_ = reinterpret_cast<page*>(first);
+    }
+
+    assert(is_aligned(base_, huge_page_size));
+
+    // nothing has been touched yet, so every page will be placed by the policy
+    if ((numa_node != any_numa_node) && bind_numa_node(base_, size, numa_node)) {
+        numa_node_ = numa_node;
+    }
+}
+
+snw::page_allocator::page_allocator(const char* path, size_t max_size)
+    : base_(nullptr)
+    , capacity_(0)
+    , brk_(0)
+    , size_(0)
+    , mode_(huge_page_mode::none)
+    , numa_node_(any_numa_node)
+    , trim_watermark_(std::numeric_limits<size_t>::max())
+    , header_(nullptr)
+    , used_(nullptr)
+{
+    int fd = open(path, O_RDWR|O_CREAT, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("failed to create page_allocator - open");
+    }
+
+    try {
+        map_file(fd, max_size);
+    }
+    catch (...) {
+        close(fd);
+        throw;
+    }
+
+    // the mapping keeps the file alive
+    close(fd);
+}
+
+snw::page_allocator::page_allocator(int fd, size_t max_size)
+    : base_(nullptr)
+    , capacity_(0)
+    , brk_(0)
+    , size_(0)
+    , mode_(huge_page_mode::none)
+    , numa_node_(any_numa_node)
+    , trim_watermark_(std::numeric_limits<size_t>::max())
+    , header_(nullptr)
+    , used_(nullptr)
+{
+    map_file(fd, max_size);
+}
+
+snw::page_allocator::~page_allocator() {
+    // pages in use in a file backed arena are kept for the next process
+    assert((header_ || (size_ == 0)) && "leaked pages");
+
+    // the free page stack lives inside the arena, so drain it before unmapping
+    while (free_pages_.pop_back()) {
+    }
+
+    void* addr = base_;
+    size_t size = capacity_ * sizeof(page);
+    if (header_) {
+        addr = header_;
+        size += file_header_size(capacity_);
+    }
+
+    int rc;
+    rc = munmap(addr, size);
+    assert(rc >= 0);
+}
+
+// the header and the bitmap are padded out to a whole number of pages
+size_t snw::page_allocator::file_header_size(size_t capacity) {
+    size_t bitmap_size = align_up(capacity, 64) / 8;
+    return align_up(sizeof(file_header) + bitmap_size, sizeof(page));
+}
+
+snw::page* snw::page_allocator::root() const {
+    if (!header_ || (header_->root == no_root)) {
+        return nullptr;
+    }
+
+    return page_at(header_->root);
+}
+
+void snw::page_allocator::set_root(page* page) {
+    assert(header_);
+    header_->root = page ? index_of(page) : no_root;
+}
+
+void snw::page_allocator::map_file(int fd, size_t max_size) {
+    if (max_size == 0) {
+        throw std::runtime_error("bad page_allocator size");
+    }
+
+    capacity_ = align_up(max_size, sizeof(page)) / sizeof(page);
+    size_t header_size = file_header_size(capacity_);
+    size_t file_size = header_size + (capacity_ * sizeof(page));
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        throw std::runtime_error("failed to create page_allocator - fstat");
+    }
+
+    // a new file reads as zeros, so the bitmap starts out empty
+    bool is_new = (st.st_size == 0);
+    if (is_new) {
+        if (ftruncate(fd, file_size) < 0) {
+            throw std::runtime_error("failed to create page_allocator - ftruncate");
+        }
+    }
+    else if (static_cast<size_t>(st.st_size) != file_size) {
+        throw std::runtime_error("failed to attach page_allocator - size mismatch");
+    }
+
+    // over-reserve so that the arena after the header is on a huge page
+    // boundary, then map the file over the aligned part
+    size_t reserve_size = file_size + huge_page_size;
+    void* reserve = mmap(nullptr, reserve_size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (reserve == MAP_FAILED) {
+        throw std::runtime_error("failed to create page_allocator - mmap");
+    }
+
+    uint8_t* reserve_first = static_cast<uint8_t*>(reserve);
+    uint8_t* reserve_last = reserve_first + reserve_size;
+    uint8_t* first = align_up(reserve_first + header_size, huge_page_size) - header_size;
+    uint8_t* last = first + file_size;
+
+    void* addr = mmap(first, file_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0);
+    if (addr == MAP_FAILED) {
+        munmap(reserve, reserve_size);
+        throw std::runtime_error("failed to create page_allocator - mmap");
+    }
+
+    // give back the slop on either side of the mapping
+    int rc;
+    if (reserve_first < first) {
+        rc = munmap(reserve_first, first - reserve_first);
+        assert(rc >= 0);
+    }
+    if (last < reserve_last) {
+        rc = munmap(last, reserve_last - last);
+        assert(rc >= 0);
+    }
+
+    file_header* header = static_cast<file_header*>(addr);
+    if (is_new) {
+        header->version = file_header::version_value;
+        header->page_size = sizeof(page);
+        header->capacity = capacity_;
+        header->root = no_root;
+        header->magic = file_header::magic_value;
+    }
+    else if ((header->magic != file_header::magic_value) ||
+             (header->version != file_header::version_value) ||
+             (header->page_size != sizeof(page)) ||
+             (header->capacity != capacity_)) {
+        munmap(addr, file_size);
+        throw std::runtime_error("failed to attach page_allocator - bad header");
+    }
+
+    header_ = header;
+    used_ = reinterpret_cast<uint64_t*>(header + 1);
+    base_ = reinterpret_cast<page*>(static_cast<uint8_t*>(addr) + header_size);
+    assert(is_aligned(base_, huge_page_size));
+
+    attach_file();
+}
+
+// rebuild the allocator state from the bitmap of pages in use
+void snw::page_allocator::attach_file() {
+    size_t word_count = align_up(capacity_, 64) / 64;
+    for (size_t i = 0; i < word_count; ++i) {
+        size_ += count_set_bits(used_[i]);
+    }
+
+    // everything above the last page in use is untouched as far as we're concerned
+    for (brk_ = capacity_; (brk_ > 0) && !test_bit(used_[(brk_ - 1) / 64], (brk_ - 1) % 64); --brk_) {
+    }
+
+    // push in reverse so that the lowest pages are handed out first
+    for (size_t i = brk_; i-- > 0;) {
+        if (!test_bit(used_[i / 64], i % 64)) {
+            free_pages_.push_back(&base_[i]);
+        }
+    }
+}
+
+snw::page* snw::page_allocator::allocate_contiguous(size_t page_count) {
+    static constexpr size_t huge_page_count = huge_page_size / sizeof(page);
+
+    size_t first = align_up(brk_, huge_page_count);
+    if ((first > capacity_) || (page_count > (capacity_ - first))) {
+        return nullptr;
+    }
+
+    // the pages skipped to get alignment can still be used for single pages
+    for (; brk_ < first; ++brk_) {
+        free_pages_.push_back(&base_[brk_]);
+    }
+
+    if (used_) {
+        for (size_t i = first; i < (first + page_count); ++i) {
+            set_bit(used_[i / 64], i % 64);
+        }
+    }
+
+    brk_ += page_count;
+    size_ += page_count;
+    return &base_[first];
+}
+
+void snw::page_allocator::deallocate_contiguous(page* first, size_t page_count) {
+    for (size_t i = 0; i < page_count; ++i) {
+        deallocate(&first[i]);
+    }
+}
+
+#else
+
+snw::page_allocator::page_allocator(size_t max_size, huge_page_mode mode, numa_node_id numa_node)
+    : base_(nullptr)
+    , capacity_(0)
+    , brk_(0)
+    , size_(0)
+    , mode_(mode)
+    , numa_node_(any_numa_node)
+    , trim_watermark_(std::numeric_limits<size_t>::max())
+    , header_(nullptr)
+    , used_(nullptr)
+{
+    throw std::runtime_error("not implemented");
+}
+
+snw::page_allocator::page_allocator(const char* path, size_t max_size)
+    : base_(nullptr)
+    , capacity_(0)
+    , brk_(0)
+    , size_(0)
+    , mode_(huge_page_mode::none)
+    , numa_node_(any_numa_node)
+    , trim_watermark_(std::numeric_limits<size_t>::max())
+    , header_(nullptr)
+    , used_(nullptr)
+{
+    throw std::runtime_error("not implemented");
+}
+
+snw::page_allocator::page_allocator(int fd, size_t max_size)
+    : base_(nullptr)
+    , capacity_(0)
+    , brk_(0)
+    , size_(0)
+    , mode_(huge_page_mode::none)
+    , numa_node_(any_numa_node)
+    , trim_watermark_(std::numeric_limits<size_t>::max())
+    , header_(nullptr)
+    , used_(nullptr)
+{
+    throw std::runtime_error("not implemented");
+}
+
+snw::page* snw::page_allocator::root() const {
+    return nullptr;
+}
+
+void snw::page_allocator::set_root(page* page) {
+    throw std::runtime_error("not implemented");
+}
+
+snw::page_allocator::~page_allocator() {
+}
+
+snw::page* snw::page_allocator::allocate_contiguous(size_t page_count) {
+    throw std::runtime_error("not implemented");
+}
+
+void snw::page_allocator::deallocate_contiguous(page* first, size_t page_count) {
+    throw std::runtime_error("not implemented");
+}
+
+#endif
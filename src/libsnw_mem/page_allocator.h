@@ -1,17 +1,177 @@
 #pragma once
 
+#include <limits>
+#include <cassert>
 #include "types.h"
+#include "platform.h"
+#include "bits.h"
+#include "page.h"
+#include "page_stack.h"
 
 namespace snw {
 
-struct page
+enum class huge_page_mode {
+    none,        // regular 4KiB pages
+    transparent, // ask the kernel to back the arena with transparent huge pages (best effort)
+    explicit_,   // back the arena with hugetlb pages (fails if none are reserved)
+};
 
+// Hands out pages from a single virtual memory reservation. The arena is
+// 2MiB aligned so that it can be backed by huge pages, and physical memory
+// is only committed when a page is first touched. Freed pages are recycled
+// through a page_stack (which stores its bookkeeping inside the free pages).
+//
+// If a numa node is given, the arena's memory policy prefers that node, so
+// pages are placed there when they're first touched (falling back to other
+// nodes rather than failing when it's full).
+//
+// The arena can also be a shared mapping of a file (or memfd), prefixed by
+// a header with a bitmap of the pages in use (mapped so that the arena
+// after it is still 2MiB aligned). Reopening the file re-attaches to the
+// pages that were in use and rebuilds the free pages from the bitmap, so
+// that a restarted process can pick up its state without rebuilding it.
+// Since the arena may be mapped at a different address, pages should refer
+// to each other by index (see index_of/page_at), and the root page of the
+// state can be recorded in the header (see set_root). Pages that were
+// sitting in a page_pool or page_cache when the process died still count
+// as in use.
 class page_allocator {
 public:
-    page_allocator(size_t );
+    static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+    static constexpr numa_node_id any_numa_node = -1;
+    static constexpr size_t no_root = ~static_cast<size_t>(0);
+
+    page_allocator(size_t max_size, huge_page_mode mode = huge_page_mode::transparent, numa_node_id numa_node = any_numa_node);
+
+    // Create or re-attach a file backed arena. Throws if an existing file
+    // wasn't created by a page_allocator with the same max_size.
+    page_allocator(const char* path, size_t max_size);
+
+    // Same as above with an open file descriptor (e.g. a memfd that was
+    // inherited across exec). The descriptor isn't closed.
+    page_allocator(int fd, size_t max_size);
+
+    page_allocator(page_allocator&&) = delete;
+    page_allocator(const page_allocator&) = delete;
     ~page_allocator();
 
+    page_allocator& operator=(page_allocator&&) = delete;
+    page_allocator& operator=(const page_allocator&) = delete;
+
+    // returns nullptr if the arena is exhausted
+    inline page* allocate() {
+        page* page = free_pages_.pop_back();
+        if (!page) {
+            if (brk_ == capacity_) {
+                return nullptr;
+            }
+
+            page = &base_[brk_++];
+        }
+
+        if (used_) {
+            set_bit(used_[index_of(page) / 64], index_of(page) % 64);
+        }
+
+        ++size_;
+        return page;
+    }
+
+    inline void deallocate(page* page) {
+        assert(owns(page));
+        assert(size_ > 0);
+
+        if (used_) {
+            assert(test_bit(used_[index_of(page) / 64], index_of(page) % 64));
+            clear_bit(used_[index_of(page) / 64], index_of(page) % 64);
+        }
+
+        free_pages_.push_back(page);
+        --size_;
+
+        // amortized: check once per page_stack node
+        if (free_pages_.full() && (free_pages_.size() > trim_watermark_)) {
+            free_pages_.trim(trim_watermark_);
+        }
+    }
+
+    // Free pages beyond this many are handed back to the kernel (see
+    // page_stack::trim). Unlimited by default.
+    void set_trim_watermark(size_t max_free_pages) {
+        trim_watermark_ = max_free_pages;
+    }
+
+    const page_trim_stats& trim_stats() const {
+        return free_pages_.trim_stats();
+    }
+
+    // Allocate page_count contiguous pages from the untouched part of the
+    // arena (e.g. to back a buddy_allocator). The first page is aligned to a
+    // huge page boundary. Returns nullptr if there isn't enough room.
+    page* allocate_contiguous(size_t page_count);
+    void deallocate_contiguous(page* first, size_t page_count);
+
+    inline bool owns(const page* page) const {
+        return (base_ <= page) && (page < (base_ + capacity_));
+    }
+
+    // position independent references to pages in the arena
+    inline size_t index_of(const page* page) const {
+        assert(owns(page));
+        return static_cast<size_t>(page - base_);
+    }
+
+    inline page* page_at(size_t index) const {
+        assert(index < capacity_);
+        return &base_[index];
+    }
+
+    bool file_backed() const {
+        return header_ != nullptr;
+    }
+
+    // The page that a re-attaching process should start from (nullptr if
+    // none). Only file backed arenas have a root.
+    page* root() const;
+    void set_root(page* page);
+
+    // number of allocated pages
+    size_t size() const {
+        return size_;
+    }
+
+    // maximum number of pages
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    huge_page_mode mode() const {
+        return mode_;
+    }
+
+    // any_numa_node if the arena isn't bound to a node (or binding failed)
+    numa_node_id numa_node() const {
+        return numa_node_;
+    }
+
+private:
+    struct file_header;
+
+    static size_t file_header_size(size_t capacity);
+    void map_file(int fd, size_t max_size);
+    void attach_file();
+
 private:
+    page*          base_;
+    size_t         capacity_;
+    size_t         brk_; // pages in [base_, base_ + brk_) have been handed out at least once
+    size_t         size_;
+    huge_page_mode mode_;
+    numa_node_id   numa_node_;
+    size_t         trim_watermark_;
+    file_header*   header_; // nullptr unless file backed
+    uint64_t*      used_;   // bitmap of the pages in use (file backed only)
+    page_stack     free_pages_;
 };
 
 }
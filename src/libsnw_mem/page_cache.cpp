@@ -0,0 +1,51 @@
+#include "page_cache.h"
+#include "zeroed_page_pool.h"
+
+snw::page_cache::page_cache(page_pool& pool, size_t max_size, zeroed_page_pool* zeroed_pool)
+    : pool_(pool)
+    , zeroed_pool_(zeroed_pool)
+    , max_size_(max_size)
+{
+}
+
+snw::page_cache::~page_cache() {
+    while (page* node = pages_.detach_node()) {
+        pool_.push_node(node);
+    }
+    while (page* node = zeroed_pages_.detach_node()) {
+        zeroed_pool_->push_node(node);
+    }
+}
+
+snw::page* snw::page_cache::refill() {
+    page* node = pool_.pop_node();
+    if (!node) {
+        return nullptr;
+    }
+
+    pages_.attach_node(node);
+    return pages_.pop_back();
+}
+
+snw::page* snw::page_cache::refill_zeroed() {
+    if (zeroed_pool_) {
+        if (page* node = zeroed_pool_->pop_node()) {
+            zeroed_pages_.attach_node(node);
+            return allocate_zeroed();
+        }
+    }
+
+    // the zeroing thread is falling behind
+    page* page = allocate();
+    if (page) {
+        memset(page, 0, sizeof(*page));
+    }
+
+    return page;
+}
+
+void snw::page_cache::drain() {
+    if (page* node = pages_.detach_node()) {
+        pool_.push_node(node);
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstring>
+#include "types.h"
+#include "page.h"
+#include "page_stack.h"
+#include "page_pool.h"
+
+namespace snw {
+
+class zeroed_page_pool;
+
+// A single-threaded cache of pages in front of a shared page_pool. Each
+// thread should own its own page_cache; the pool is only consulted when
+// the cache runs dry, or when it grows past max_size (and then only in
+// whole page_stack nodes).
+//
+// Zeroed pages come from a separate stack that is refilled from a
+// zeroed_page_pool (when one is given) so that they don't need to be
+// cleared on the allocating thread.
+class page_cache {
+public:
+    page_cache(page_pool& pool, size_t max_size = 2 * page_stack::max_node_size, zeroed_page_pool* zeroed_pool = nullptr);
+    page_cache(page_cache&&) = delete;
+    page_cache(const page_cache&) = delete;
+    ~page_cache();
+
+    page_cache& operator=(page_cache&&) = delete;
+    page_cache& operator=(const page_cache&) = delete;
+
+    // returns nullptr if the pool is exhausted
+    inline page* allocate() {
+        if (page* page = pages_.pop_back()) {
+            return page;
+        }
+
+        return refill();
+    }
+
+    // returns nullptr if the pool is exhausted
+    inline page* allocate_zeroed() {
+        if (!zeroed_pages_.empty()) {
+            // node pages hold the list of zeroed pages, so they're dirty
+            bool dirty = zeroed_pages_.at_node();
+
+            page* page = zeroed_pages_.pop_back();
+            if (dirty) {
+                memset(page, 0, sizeof(*page));
+            }
+
+            return page;
+        }
+
+        return refill_zeroed();
+    }
+
+    inline void deallocate(page* page) {
+        // only give back full nodes so that the pool sees big batches
+        if ((pages_.size() >= max_size_) && pages_.full()) {
+            drain();
+        }
+
+        pages_.push_back(page);
+    }
+
+    // number of cached pages
+    size_t size() const {
+        return pages_.size();
+    }
+
+    // refaulted counts pages that were trimmed by the pool before being handed out here
+    const page_trim_stats& trim_stats() const {
+        return pages_.trim_stats();
+    }
+
+private:
+    page* refill();
+    page* refill_zeroed();
+    void drain();
+
+private:
+    page_pool&        pool_;
+    zeroed_page_pool* zeroed_pool_;
+    size_t            max_size_;
+    page_stack        pages_;
+    page_stack        zeroed_pages_;
+};
+
+}
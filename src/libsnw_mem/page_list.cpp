@@ -1,6 +1,10 @@
 #include "page_list.h"
+#include <cstring>
+#include <cassert>
+#include <new>
 
 snw::page_list::page_list()
+    : size_(0)
 {
 }
 
@@ -13,66 +17,143 @@ bool snw::page_list::empty() const
     return page_nodes_.empty();
 }
 
-void snw::page_list::push_front(page* page)
+size_t snw::page_list::size() const
 {
-    if(empty() || page_nodes_.front().pages.full()) {
-        void* ptr = page;
-        page->~page();
+    return size_;
+}
 
-        auto node = new(ptr) page_node;
-        page_nodes_.push_front(*node);
+void snw::page_list::push_front(page* page)
+{
+    if(empty() || page_nodes_.front().full()) {
+        page_nodes_.push_front(make_node(page));
     }
     else {
-        auto& pages = page_nodes_.front().pages;
-        pages.insert(pages.begin(), page); // TODO: queue instead of array
+        page_nodes_.front().push_front(page);
     }
+
+    ++size_;
 }
 
 void snw::page_list::push_back(page* page)
 {
-    if(empty() || page_nodes_.back().pages.full()) {
-        void* ptr = page;
-        page->~page();
-
-        auto node = new(ptr) page_node;
-        page_nodes_.push_back(*node);
+    if(empty() || page_nodes_.back().full()) {
+        page_nodes_.push_back(make_node(page));
     }
     else {
-        auto& pages = page_nodes_.back().pages;
-        pages.insert(pages.begin(), page);
+        page_nodes_.back().push_back(page);
     }
+
+    ++size_;
 }
 
 snw::page* snw::page_list::pop_front()
 {
     assert(!empty());
 
-    page_node& node = page_nodes_.front();
-    if(node.pages.empty()) {
-        void* ptr = &node;
-        node.~page_node();
-        return new(ptr) page;
-    }
-    else {
-        page* result = node.pages.front();
-        node.pages.erase(node.pages.begin()); // TODO: use a queue instead of an array
-        return result;
+    page_node* node = &page_nodes_.front();
+    page* result = (*node)[0];
+    if(result == node->self()) {
+        if(node->size == 1) {
+            --size_;
+            return destroy_node(*node);
+        }
+
+        node = &rehost(*node, node->size / 2);
     }
+
+    node->pop_front();
+
+    --size_;
+    return result;
 }
 
 snw::page* snw::page_list::pop_back()
 {
     assert(!empty());
 
-    page_node& node = page_nodes_.back();
-    if(node.pages.empty()) {
-        void* ptr = &node;
-        node.~page_node();
-        return new(ptr) page;
-    }
-    else {
-        page* result = node.pages.back();
-        node.pages.erase(node.pages.end());
-        return result;
+    page_node* node = &page_nodes_.back();
+    page* result = (*node)[node->size - 1];
+    if(result == node->self()) {
+        if(node->size == 1) {
+            --size_;
+            return destroy_node(*node);
+        }
+
+        node = &rehost(*node, (node->size - 1) / 2);
     }
+
+    node->pop_back();
+
+    --size_;
+    return result;
+}
+
+void snw::page_list::splice_front(page_list& other)
+{
+    page_nodes_.splice(page_nodes_.begin(), other.page_nodes_);
+    size_ += other.size_;
+    other.size_ = 0;
+}
+
+void snw::page_list::splice_back(page_list& other)
+{
+    page_nodes_.splice(page_nodes_.end(), other.page_nodes_);
+    size_ += other.size_;
+    other.size_ = 0;
+}
+
+snw::page_list::const_iterator snw::page_list::begin() const
+{
+    return const_iterator(page_nodes_.begin(), 0);
+}
+
+snw::page_list::const_iterator snw::page_list::end() const
+{
+    return const_iterator(page_nodes_.end(), 0);
+}
+
+snw::page_list::page_node& snw::page_list::make_node(page* page)
+{
+    void* ptr = page;
+    page->~page();
+
+    auto node = new(ptr) page_node;
+    node->push_back(page);
+    return *node;
+}
+
+snw::page* snw::page_list::destroy_node(page_node& node)
+{
+    assert(node.size == 1);
+    assert(node[0] == node.self());
+
+    void* ptr = &node;
+    node.~page_node();
+    return new(ptr) page;
+}
+
+// The node's own page is about to be popped, but other pages still
+// reference it. Move the node into a page from the middle of the ring
+// so that it won't need to move again for another size/2 pops at
+// either end (this is a 4KiB copy, so it's still O(1)).
+snw::page_list::page_node& snw::page_list::rehost(page_node& node, uint32_t index)
+{
+    assert(node.size > 1);
+
+    page* host = node[index];
+    assert(host != node.self());
+
+    void* ptr = host;
+    host->~page();
+
+    auto new_node = new(ptr) page_node;
+    new_node->first = node.first;
+    new_node->size = node.size;
+    memcpy(new_node->pages, node.pages, sizeof(node.pages));
+
+    page_nodes_.insert(page_node_list::const_iterator(static_cast<const intrusive_list_node*>(&node.node)), *new_node);
+    node.~page_node();
+    new(&node) page;
+
+    return *new_node;
 }
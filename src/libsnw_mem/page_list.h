@@ -1,38 +1,184 @@
 #pragma once
 
+#include <iterator>
+#include <cstddef>
+#include "types.h"
 #include "intrusive_list.h"
-#include "array.h"
 #include "page.h"
 
 namespace snw {
 
+// A double-ended queue of pages. Like page_stack, the bookkeeping lives
+// inside the listed pages: each node is one of the pages in the list, and
+// holds a ring of page pointers (including one to itself). Pushing and
+// popping at either end is O(1), and whole lists can be spliced in O(1).
 class page_list {
+private:
+    struct page_node {
+        static constexpr uint32_t capacity = (sizeof(page) - sizeof(intrusive_list_node) - (2 * sizeof(uint32_t))) / sizeof(page*);
+
+        intrusive_list_node node;
+        uint32_t            first; // ring index of the first page
+        uint32_t            size;
+        page*               pages[capacity];
+
+        page_node()
+            : first(0)
+            , size(0)
+        {
+        }
+
+        page* self() {
+            return reinterpret_cast<page*>(this);
+        }
+
+        bool full() const {
+            return size == capacity;
+        }
+
+        page* operator[](uint32_t index) const {
+            uint32_t offset = first + index;
+            if(offset >= capacity) {
+                offset -= capacity;
+            }
+
+            return pages[offset];
+        }
+
+        void push_front(page* page) {
+            first = (first == 0) ? (capacity - 1) : (first - 1);
+            pages[first] = page;
+            ++size;
+        }
+
+        void push_back(page* page) {
+            uint32_t offset = first + size;
+            if(offset >= capacity) {
+                offset -= capacity;
+            }
+
+            pages[offset] = page;
+            ++size;
+        }
+
+        void pop_front() {
+            first = (first == (capacity - 1)) ? 0 : (first + 1);
+            --size;
+        }
+
+        void pop_back() {
+            --size;
+        }
+    };
+    static_assert(sizeof(page_node) == sizeof(page), "");
+
+    using page_node_list = intrusive_list<page_node, &page_node::node>;
+
+public:
+    class const_iterator {
+    public:
+        using value_type = page*;
+        using pointer = page* const*;
+        using reference = page*;
+        using difference_type = ptrdiff_t;
+        using iterator_category = std::bidirectional_iterator_tag;
+
+        const_iterator()
+            : index_(0)
+        {
+        }
+
+        reference operator*() const {
+            return (*node_)[index_];
+        }
+
+        const_iterator& operator++() {
+            if(++index_ == node_->size) {
+                ++node_;
+                index_ = 0;
+            }
+
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto result = *this;
+            ++(*this);
+            return result;
+        }
+
+        const_iterator& operator--() {
+            if(index_ == 0) {
+                --node_;
+                index_ = node_->size - 1;
+            }
+            else {
+                --index_;
+            }
+
+            return *this;
+        }
+
+        const_iterator operator--(int) {
+            auto result = *this;
+            --(*this);
+            return result;
+        }
+
+        bool operator==(const const_iterator& rhs) const {
+            return (node_ == rhs.node_) && (index_ == rhs.index_);
+        }
+
+        bool operator!=(const const_iterator& rhs) const {
+            return !(*this == rhs);
+        }
+
+    private:
+        friend class page_list;
+
+        const_iterator(page_node_list::const_iterator node, uint32_t index)
+            : node_(node)
+            , index_(index)
+        {
+        }
+
+        page_node_list::const_iterator node_;
+        uint32_t                       index_;
+    };
+
+    // the listed pages hold the list structure, so they can't be modified in place
+    using iterator = const_iterator;
+
 public:
     page_list();
+    page_list(const page_list&) = delete;
     ~page_list();
 
+    page_list& operator=(const page_list&) = delete;
+
     bool empty() const;
+    size_t size() const;
 
     void push_front(page* page);
     void push_back(page* page);
     page* pop_front();
     page* pop_back();
 
-    // iterator begin();
-    // const_iterator begin() const;
-    // iterator end();
-    // const_iterator end() const;
+    // move every page in other to the front/back of this list in O(1)
+    void splice_front(page_list& other);
+    void splice_back(page_list& other);
 
-private:
-    struct page_node {
-        intrusive_list_node node;
-        array<page*, (4096 - sizeof(intrusive_list_node) - sizeof(size_t)) / sizeof(page*)> pages;
-    };
-    static_assert(sizeof(page_node) == 4096, "");
+    const_iterator begin() const;
+    const_iterator end() const;
 
-    using page_node_list = intrusive_list<page_node, &page_node::node>;
+private:
+    page_node& make_node(page* page);
+    page* destroy_node(page_node& node);
+    page_node& rehost(page_node& node, uint32_t index);
 
+private:
     page_node_list page_nodes_;
+    size_t         size_;
 };
 
 }
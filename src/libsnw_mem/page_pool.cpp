@@ -0,0 +1,72 @@
+#include "page_pool.h"
+#include <cassert>
+
+snw::page_pool::page_pool(page_allocator& allocator, size_t trim_watermark)
+    : allocator_(allocator)
+    , trim_watermark_(trim_watermark)
+    , trimmed_(0)
+{
+}
+
+snw::page_pool::~page_pool() {
+    page_stack pages;
+    while (page* node = nodes_.pop_node()) {
+        pages.attach_node(node);
+    }
+    while (page* page = pages.pop_back()) {
+        allocator_.deallocate(page);
+    }
+}
+
+snw::page* snw::page_pool::pop_node() {
+    if (page* node = nodes_.pop_node()) {
+        return node;
+    }
+
+    return refill();
+}
+
+void snw::page_pool::push_node(page* node) {
+    assert(node);
+
+    if (nodes_.size() >= trim_watermark_) {
+        trimmed_.fetch_add(page_stack::trim_node(node), std::memory_order_relaxed);
+    }
+
+    nodes_.push_node(node);
+}
+
+size_t snw::page_pool::size() const {
+    return nodes_.size();
+}
+
+size_t snw::page_pool::trimmed() const {
+    return trimmed_.load(std::memory_order_relaxed);
+}
+
+size_t snw::page_pool::allocated() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocator_.size();
+}
+
+snw::page* snw::page_pool::refill() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // somebody may have pushed a node while we were waiting for the lock
+    if (page* node = nodes_.pop_node()) {
+        return node;
+    }
+
+    // carve a fresh node out of the allocator
+    page_stack pages;
+    for (size_t i = 0; i < page_stack::max_node_size; ++i) {
+        page* page = allocator_.allocate();
+        if (!page) {
+            break;
+        }
+
+        pages.push_back(page);
+    }
+
+    return pages.detach_node();
+}
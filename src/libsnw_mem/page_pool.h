@@ -0,0 +1,60 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include "types.h"
+#include "page.h"
+#include "page_stack.h"
+#include "page_allocator.h"
+#include "concurrent_page_stack.h"
+
+namespace snw {
+
+// A thread-safe pool of pages shared by a set of page_caches. Pages move in
+// and out of the pool a whole page_stack node at a time, so the pool is
+// touched roughly once per page_stack::max_node_size page allocations.
+//
+// Pushing and popping nodes is lock-free; the mutex is only taken to
+// refill the pool from the page_allocator.
+//
+// Once the pool holds more than trim_watermark pages, the pages of every
+// node that is pushed are handed back to the kernel (see page_stack::trim).
+class page_pool {
+public:
+    page_pool(page_allocator& allocator, size_t trim_watermark = std::numeric_limits<size_t>::max());
+    page_pool(page_pool&&) = delete;
+    page_pool(const page_pool&) = delete;
+    ~page_pool();
+
+    page_pool& operator=(page_pool&&) = delete;
+    page_pool& operator=(const page_pool&) = delete;
+
+    // Returns a node (see page_stack::detach_node), refilling from the
+    // page_allocator if the pool is empty. Returns nullptr if both are exhausted.
+    page* pop_node();
+
+    // Return a node obtained from page_stack::detach_node.
+    void push_node(page* node);
+
+    // approximate number of pages in the pool
+    size_t size() const;
+
+    // number of pages that have been trimmed
+    size_t trimmed() const;
+
+    // number of pages handed out by the page_allocator (including those in the pool)
+    size_t allocated() const;
+
+private:
+    page* refill();
+
+private:
+    mutable std::mutex    mutex_;
+    page_allocator&       allocator_;
+    size_t                trim_watermark_;
+    std::atomic<size_t>   trimmed_;
+    concurrent_page_stack nodes_;
+};
+
+}
@@ -1,16 +1,30 @@
 #include "page_stack.h"
+#include "platform.h"
+#include "align.h"
+#include <algorithm>
 #include <cstring>
 #include <new>
 
+#if defined(SNW_OS_UNIX)
+#include <sys/mman.h>
+#endif
+
+constexpr size_t snw::page_stack::max_node_size;
+
 snw::page_stack::page_stack()
     : head_(nullptr)
+    , size_(0)
 {
+    memset(&stats_, 0, sizeof(stats_));
 }
 
 snw::page_stack::page_stack(page_stack&& other)
 {
     head_ = other.head_;
+    size_ = other.size_;
+    stats_ = other.stats_;
     other.head_ = nullptr;
+    other.size_ = 0;
 }
 
 snw::page_stack::~page_stack()
@@ -24,7 +38,10 @@ snw::page_stack& snw::page_stack::operator=(page_stack&& rhs)
         assert(empty());
 
         head_ = rhs.head_;
+        size_ = rhs.size_;
+        stats_ = rhs.stats_;
         rhs.head_ = nullptr;
+        rhs.size_ = 0;
     }
 
     return *this;
@@ -54,3 +71,108 @@ snw::page* snw::page_stack::pop_node()
     head->~node();
     return new(ptr) page;
 }
+
+snw::page* snw::page_stack::detach_node()
+{
+    if(!head_) {
+        return nullptr;
+    }
+
+    auto head = head_;
+    head_ = head->header.prev;
+    head->header.prev = nullptr;
+    size_ -= head->header.top + 1;
+
+    return reinterpret_cast<page*>(head);
+}
+
+void snw::page_stack::attach_node(page* page)
+{
+    auto head = reinterpret_cast<node*>(page);
+    assert(!head->header.prev);
+    assert(head->header.top <= node::capacity);
+
+    head->header.prev = head_;
+    head_ = head;
+    size_ += head->header.top + 1;
+}
+
+size_t snw::page_stack::node_size(const page* page)
+{
+    return reinterpret_cast<const node*>(page)->header.top + 1;
+}
+
+size_t snw::page_stack::trim(size_t max_resident)
+{
+    size_t trimmed = 0;
+
+    // walk from the newest node to the oldest
+    size_t resident = 0;
+    for(node* node = head_; node; node = node->header.prev) {
+        ++resident; // the node itself
+
+        uint32_t keep = static_cast<uint32_t>(std::min<size_t>(node->header.top, max_resident - std::min(resident, max_resident)));
+        resident += keep;
+
+        uint32_t last = node->header.top - keep;
+        if(node->header.trimmed < last) {
+            trimmed += trim_node(node, node->header.trimmed, last);
+            node->header.trimmed = last;
+        }
+    }
+
+    stats_.trimmed += trimmed;
+    return trimmed;
+}
+
+size_t snw::page_stack::trim_node(page* page)
+{
+    auto node = reinterpret_cast<page_stack::node*>(page);
+
+    size_t trimmed = trim_node(node, node->header.trimmed, node->header.top);
+    node->header.trimmed = node->header.top;
+    return trimmed;
+}
+
+// release pages[first, last) in as few madvise calls as possible
+size_t snw::page_stack::trim_node(node* node, uint32_t first, uint32_t last)
+{
+    size_t trimmed = 0;
+
+#if defined(SNW_OS_UNIX)
+#if defined(MADV_FREE)
+    static constexpr int advice = MADV_FREE;
+#else
+    static constexpr int advice = MADV_DONTNEED;
+#endif
+
+    // coalesce runs of adjacent pages (in either direction)
+    uint8_t* run_first = nullptr;
+    uint8_t* run_last = nullptr;
+    auto flush = [&]() {
+        if(run_first && is_aligned(run_first, sizeof(page))) {
+            if(madvise(run_first, run_last - run_first, advice) == 0) {
+                trimmed += (run_last - run_first) / sizeof(page);
+            }
+        }
+    };
+
+    for(uint32_t i = first; i < last; ++i) {
+        auto data = reinterpret_cast<uint8_t*>(node->pages[i]);
+        if(run_first && (data == run_last)) {
+            run_last += sizeof(page);
+        }
+        else if(run_first && ((data + sizeof(page)) == run_first)) {
+            run_first = data;
+        }
+        else {
+            flush();
+            run_first = data;
+            run_last = data + sizeof(page);
+        }
+    }
+    flush();
+#endif
+
+    return trimmed;
+}
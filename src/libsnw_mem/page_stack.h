@@ -6,8 +6,38 @@
 
 namespace snw {
 
+class concurrent_page_stack;
+
+struct page_trim_stats {
+    size_t trimmed;   // pages that were handed back to the kernel
+    size_t refaulted; // trimmed pages that were popped again (and will be faulted back in)
+};
+
 class page_stack {
+    friend class concurrent_page_stack;
+
+private:
+    struct node;
+
+    struct node_header {
+        node*    prev;
+        uint32_t top;
+        uint32_t trimmed; // pages[0, trimmed) have been handed back to the kernel
+    };
+
+    struct node {
+        static constexpr uint32_t capacity = (sizeof(page) - sizeof(node_header)) / sizeof(page*);
+
+        node_header header;
+        page*       pages[capacity];
+    };
+    static_assert(sizeof(node) == sizeof(page), "");
+
 public:
+    // the most pages that can be moved with a single detach_node/attach_node
+    // (a node's own page plus the pages it references)
+    static constexpr size_t max_node_size = node::capacity + 1;
+
     page_stack();
     page_stack(page_stack&& other);
     page_stack(const page_stack&) = delete;
@@ -20,7 +50,24 @@ public:
         return !head_;
     }
 
+    // number of pages (including the ones being used as nodes)
+    inline size_t size() const {
+        return size_;
+    }
+
+    // true if the next push_back will start a new node
+    inline bool full() const {
+        return !head_ || (head_->header.top == node::capacity);
+    }
+
+    // true if the next pop_back will return a page that was being used as a node
+    inline bool at_node() const {
+        return head_ && (head_->header.top == 0);
+    }
+
     inline void push_back(page* page) {
+        ++size_;
+
         if(!head_ || (head_->header.top == node::capacity)) {
             push_node(page);
             return;
@@ -35,36 +82,64 @@ public:
             return nullptr;
         }
 
+        --size_;
+
         if(head_->header.top == 0) {
             return pop_node();
         }
 
         auto head = reinterpret_cast<node*>(head_);
-        return head->pages[--head->header.top];
+        page* page = head->pages[--head->header.top];
+        if(head->header.top < head->header.trimmed) {
+            head->header.trimmed = head->header.top;
+            ++stats_.refaulted;
+        }
+
+        return page;
     }
 
-private:
-    void push_node(page* page);
-    page* pop_node();
+    // Hand the physical memory behind every page but the newest max_resident
+    // pages back to the kernel (with MADV_FREE where available). Pages used as
+    // nodes are never trimmed. Returns the number of pages that were trimmed.
+    size_t trim(size_t max_resident);
 
-private:
-    struct node;
+    const page_trim_stats& trim_stats() const {
+        return stats_;
+    }
 
-    struct node_header {
-        node*    prev;
-        uint32_t top;
-        uint32_t reserved;
-    };
+    // Unlink the top node (and every page it references) in O(1). The
+    // returned page is the node itself, and can be handed to attach_node
+    // on another page_stack. Returns nullptr if the stack is empty.
+    page* detach_node();
 
-    struct node {
-        static constexpr uint32_t capacity = (sizeof(page) - sizeof(node_header)) / sizeof(page*);
+    // Push a node returned by detach_node in O(1).
+    void attach_node(page* page);
 
-        node_header header;
-        page*       pages[capacity];
-    };
-    static_assert(sizeof(node) == sizeof(page), "");
+    // number of pages that would be moved by attach_node(page)
+    static size_t node_size(const page* page);
+
+    // trim every page referenced by a detached node
+    static size_t trim_node(page* page);
+
+    // call f(page*) for every page referenced by a detached node (not including the node itself)
+    template<typename F>
+    static void for_each_node_page(page* page, F&& f) {
+        auto node = reinterpret_cast<page_stack::node*>(page);
+        for(uint32_t i = 0; i < node->header.top; ++i) {
+            f(node->pages[i]);
+        }
+    }
 
-    node* head_;
+private:
+    void push_node(page* page);
+    page* pop_node();
+
+    static size_t trim_node(node* node, uint32_t first, uint32_t last);
+
+private:
+    node*           head_;
+    size_t          size_;
+    page_trim_stats stats_;
 };
 
 }
\ No newline at end of file
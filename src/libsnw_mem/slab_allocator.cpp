@@ -0,0 +1,173 @@
+#include "slab_allocator.h"
+#include "align.h"
+#include <cstring>
+#include <new>
+
+constexpr int snw::slab_allocator::size_class_count;
+constexpr size_t snw::slab_allocator::min_size;
+constexpr size_t snw::slab_allocator::max_size;
+constexpr size_t snw::slab_allocator::slab_header_size;
+
+snw::slab_allocator::slab_allocator(buddy_allocator& spans)
+    : spans_(spans)
+{
+    for (size_class& size_class: size_classes_) {
+        size_class.size = 0;
+    }
+}
+
+snw::slab_allocator::~slab_allocator() {
+    for (int i = 0; i < size_class_count; ++i) {
+        size_class& size_class = size_classes_[i];
+        assert(size_class.size == 0 && "leaked objects");
+
+        while (!size_class.partial_slabs.empty()) {
+            slab& slab = size_class.partial_slabs.front();
+            size_class.partial_slabs.pop_front();
+            delete_slab(i, &slab);
+        }
+    }
+}
+
+void* snw::slab_allocator::allocate(size_t size) {
+    if (size > max_size) {
+        return nullptr;
+    }
+
+    void* object = nullptr;
+    allocate_batch(size_class_of(size), &object, 1);
+    return object;
+}
+
+void snw::slab_allocator::deallocate(void* ptr, size_t size) {
+    deallocate_batch(size_class_of(size), &ptr, 1);
+}
+
+size_t snw::slab_allocator::allocate_batch(int size_class_index, void** objects, size_t count) {
+    size_class& size_class = size_classes_[size_class_index];
+    size_t object_size = class_size(size_class_index);
+    size_t capacity = slab_capacity(size_class_index);
+
+    std::lock_guard<std::mutex> lock(size_class.mutex);
+
+    size_t i = 0;
+    while (i < count) {
+        if (size_class.partial_slabs.empty()) {
+            slab* slab = new_slab(size_class_index);
+            if (!slab) {
+                break;
+            }
+
+            size_class.partial_slabs.push_front(*slab);
+        }
+
+        slab& slab = size_class.partial_slabs.front();
+
+        // prefer recently freed (and probably cached) objects
+        for (; (i < count) && slab.free_list; ++i) {
+            void* object = slab.free_list;
+            memcpy(&slab.free_list, object, sizeof(void*));
+            objects[i] = object;
+            ++slab.live;
+        }
+
+        // carve new objects lazily so that untouched memory stays untouched
+        for (; (i < count) && (slab.brk < capacity); ++i) {
+            uint8_t* first = reinterpret_cast<uint8_t*>(&slab) + slab_header_size;
+            objects[i] = first + (slab.brk++ * object_size);
+            ++slab.live;
+        }
+
+        if (slab.live == capacity) {
+            size_class.partial_slabs.pop_front();
+        }
+    }
+
+    size_class.size += i;
+    return i;
+}
+
+void snw::slab_allocator::deallocate_batch(int size_class_index, void* const* objects, size_t count) {
+    size_class& size_class = size_classes_[size_class_index];
+    size_t slab_size = slab_page_count(size_class_index) * sizeof(page);
+
+    std::lock_guard<std::mutex> lock(size_class.mutex);
+
+    for (size_t i = 0; i < count; ++i) {
+        void* object = objects[i];
+        slab* slab = reinterpret_cast<slab_allocator::slab*>(align_down(reinterpret_cast<uintptr_t>(object), slab_size));
+        assert(slab->live > 0);
+
+        memcpy(object, &slab->free_list, sizeof(void*));
+        slab->free_list = object;
+        --slab->live;
+
+        if (!slab->node.is_linked()) {
+            // it was full
+            size_class.partial_slabs.push_back(*slab);
+        }
+        else if ((slab->live == 0) && (&size_class.partial_slabs.front() != slab)) {
+            // keep at most one empty slab around
+            size_class.partial_slabs.erase(slab_list::const_iterator(static_cast<const intrusive_list_node*>(&slab->node)));
+            delete_slab(size_class_index, slab);
+        }
+    }
+
+    size_class.size -= count;
+}
+
+size_t snw::slab_allocator::size(int size_class) const {
+    std::lock_guard<std::mutex> lock(size_classes_[size_class].mutex);
+    return size_classes_[size_class].size;
+}
+
+// slabs for the small classes fit in a page, the larger ones use enough
+// pages to hold at least 15 objects
+size_t snw::slab_allocator::slab_page_count(int size_class) {
+    size_t object_size = class_size(size_class);
+    size_t page_count = 1;
+    while ((page_count * sizeof(page)) < (object_size * 16)) {
+        page_count *= 2;
+    }
+
+    return page_count;
+}
+
+size_t snw::slab_allocator::slab_capacity(int size_class) {
+    return ((slab_page_count(size_class) * sizeof(page)) - slab_header_size) / class_size(size_class);
+}
+
+snw::slab_allocator::slab* snw::slab_allocator::new_slab(int size_class) {
+    size_t page_count = slab_page_count(size_class);
+
+    page* span;
+    {
+        std::lock_guard<std::mutex> lock(spans_mutex_);
+        span = spans_.allocate(page_count);
+    }
+    if (!span) {
+        return nullptr;
+    }
+
+    assert(is_aligned(span, page_count * sizeof(page)));
+
+    void* ptr = span;
+    span->~page();
+
+    auto result = new(ptr) slab;
+    result->free_list = nullptr;
+    result->brk = 0;
+    result->live = 0;
+    return result;
+}
+
+void snw::slab_allocator::delete_slab(int size_class, slab* slab) {
+    assert(slab->live == 0);
+
+    void* ptr = slab;
+    slab->~slab();
+    page* span = new(ptr) page;
+
+    std::lock_guard<std::mutex> lock(spans_mutex_);
+    spans_.deallocate(span, slab_page_count(size_class));
+}
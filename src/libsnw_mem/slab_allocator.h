@@ -0,0 +1,97 @@
+#pragma once
+
+#include <mutex>
+#include <cassert>
+#include "types.h"
+#include "page.h"
+#include "intrusive_list.h"
+#include "buddy_allocator.h"
+
+namespace snw {
+
+// Carves small objects (16B to 2KiB, in power of 2 size classes) out of
+// page spans from a buddy_allocator. Each slab keeps an intrusive free list
+// of its objects, and slabs with free objects are kept on a per size class
+// list. Slabs for the larger classes span several pages so that the slab
+// header doesn't waste half of a page.
+//
+// Slabs are found from object addresses by alignment, so the buddy
+// allocator's region must be aligned to at least max_slab_size (regions
+// from page_allocator::allocate_contiguous are).
+//
+// This is thread-safe, but every call takes a lock. Threads should
+// allocate through a slab_cache, which talks to this in batches.
+class slab_allocator {
+public:
+    static constexpr int    size_class_count = 8;
+    static constexpr size_t min_size = 16;
+    static constexpr size_t max_size = min_size << (size_class_count - 1);
+
+    slab_allocator(buddy_allocator& spans);
+    slab_allocator(slab_allocator&&) = delete;
+    slab_allocator(const slab_allocator&) = delete;
+    ~slab_allocator();
+
+    slab_allocator& operator=(slab_allocator&&) = delete;
+    slab_allocator& operator=(const slab_allocator&) = delete;
+
+    // Returns nullptr if size > max_size or the buddy_allocator is exhausted.
+    void* allocate(size_t size);
+
+    // size must be the one that was passed to allocate
+    void deallocate(void* ptr, size_t size);
+
+    // Allocate up to count objects of a size class, returning how many were allocated.
+    size_t allocate_batch(int size_class, void** objects, size_t count);
+    void deallocate_batch(int size_class, void* const* objects, size_t count);
+
+    // number of live objects in a size class
+    size_t size(int size_class) const;
+
+    static int size_class_of(size_t size) {
+        assert(size <= max_size);
+
+        int size_class = 0;
+        while ((min_size << size_class) < size) {
+            ++size_class;
+        }
+
+        return size_class;
+    }
+
+    static size_t class_size(int size_class) {
+        return min_size << size_class;
+    }
+
+private:
+    struct slab {
+        intrusive_list_node node;      // linked while the slab has free objects
+        void*               free_list; // objects that have been freed
+        uint32_t            brk;       // objects that have been carved out so far
+        uint32_t            live;
+    };
+
+    using slab_list = intrusive_list<slab, &slab::node>;
+
+    static constexpr size_t slab_header_size = 64;
+    static_assert(sizeof(slab) <= slab_header_size, "");
+
+    struct size_class {
+        mutable std::mutex mutex;
+        slab_list          partial_slabs;
+        size_t             size;
+    };
+
+    static size_t slab_page_count(int size_class);
+    static size_t slab_capacity(int size_class);
+
+    slab* new_slab(int size_class);
+    void delete_slab(int size_class, slab* slab);
+
+private:
+    std::mutex       spans_mutex_;
+    buddy_allocator& spans_;
+    size_class       size_classes_[size_class_count];
+};
+
+}
@@ -0,0 +1,44 @@
+#include "slab_cache.h"
+
+constexpr size_t snw::slab_cache::magazine_capacity;
+
+snw::slab_cache::slab_cache(slab_allocator& allocator)
+    : allocator_(allocator)
+{
+    for (magazine& magazine: magazines_) {
+        magazine.size = 0;
+    }
+}
+
+snw::slab_cache::~slab_cache() {
+    for (int i = 0; i < slab_allocator::size_class_count; ++i) {
+        magazine& magazine = magazines_[i];
+        allocator_.deallocate_batch(i, magazine.objects, magazine.size);
+        magazine.size = 0;
+    }
+}
+
+void* snw::slab_cache::refill(int size_class) {
+    magazine& magazine = magazines_[size_class];
+    assert(magazine.size == 0);
+
+    magazine.size = allocator_.allocate_batch(size_class, magazine.objects, magazine_capacity / 2);
+    if (magazine.size == 0) {
+        return nullptr;
+    }
+
+    return magazine.objects[--magazine.size];
+}
+
+void snw::slab_cache::drain(int size_class) {
+    magazine& magazine = magazines_[size_class];
+    assert(magazine.size == magazine_capacity);
+
+    // give back the older half
+    size_t count = magazine_capacity / 2;
+    allocator_.deallocate_batch(size_class, magazine.objects, count);
+    for (size_t i = count; i < magazine.size; ++i) {
+        magazine.objects[i - count] = magazine.objects[i];
+    }
+    magazine.size -= count;
+}
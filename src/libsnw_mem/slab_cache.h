@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cassert>
+#include "types.h"
+#include "slab_allocator.h"
+
+namespace snw {
+
+// A single-threaded magazine of objects for each slab_allocator size
+// class. Each thread should own its own slab_cache; the slab_allocator
+// is only touched (in batches of half a magazine) when a magazine runs
+// empty or overflows.
+class slab_cache {
+public:
+    static constexpr size_t magazine_capacity = 64;
+
+    slab_cache(slab_allocator& allocator);
+    slab_cache(slab_cache&&) = delete;
+    slab_cache(const slab_cache&) = delete;
+    ~slab_cache();
+
+    slab_cache& operator=(slab_cache&&) = delete;
+    slab_cache& operator=(const slab_cache&) = delete;
+
+    // Returns nullptr if size > slab_allocator::max_size or the allocator is exhausted.
+    inline void* allocate(size_t size) {
+        if (size > slab_allocator::max_size) {
+            return nullptr;
+        }
+
+        magazine& magazine = magazines_[slab_allocator::size_class_of(size)];
+        if (magazine.size > 0) {
+            return magazine.objects[--magazine.size];
+        }
+
+        return refill(slab_allocator::size_class_of(size));
+    }
+
+    // size must be the one that was passed to allocate
+    inline void deallocate(void* ptr, size_t size) {
+        int size_class = slab_allocator::size_class_of(size);
+
+        magazine& magazine = magazines_[size_class];
+        if (magazine.size == magazine_capacity) {
+            drain(size_class);
+        }
+
+        magazine.objects[magazine.size++] = ptr;
+    }
+
+private:
+    void* refill(int size_class);
+    void drain(int size_class);
+
+private:
+    struct magazine {
+        size_t size;
+        void*  objects[magazine_capacity];
+    };
+
+    slab_allocator& allocator_;
+    magazine        magazines_[slab_allocator::size_class_count];
+};
+
+}
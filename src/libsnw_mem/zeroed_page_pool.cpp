@@ -0,0 +1,99 @@
+#include "zeroed_page_pool.h"
+#include "platform.h"
+#include "types.h"
+#include <chrono>
+
+#if defined(SNW_OS_LINUX)
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+
+void snw::zero_page(page* page) {
+    const __m128i zero = _mm_setzero_si128();
+
+    auto first = reinterpret_cast<__m128i*>(page->data);
+    auto last = reinterpret_cast<__m128i*>(page->data + sizeof(page->data));
+    for (__m128i* it = first; it != last; it += 4) {
+        _mm_stream_si128(it + 0, zero);
+        _mm_stream_si128(it + 1, zero);
+        _mm_stream_si128(it + 2, zero);
+        _mm_stream_si128(it + 3, zero);
+    }
+}
+
+snw::zeroed_page_pool::zeroed_page_pool(page_pool& pool, size_t target_size)
+    : pool_(pool)
+    , target_size_(target_size)
+    , running_(true)
+{
+    thread_ = std::thread([this]() {
+        run();
+    });
+}
+
+snw::zeroed_page_pool::~zeroed_page_pool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cond_.notify_one();
+    thread_.join();
+
+    while (page* node = nodes_.pop_node()) {
+        pool_.push_node(node);
+    }
+}
+
+snw::page* snw::zeroed_page_pool::pop_node() {
+    page* node = nodes_.pop_node();
+
+    // wake the zeroing thread once we're down to half stock
+    if (nodes_.size() < (target_size_ / 2)) {
+        cond_.notify_one();
+    }
+
+    return node;
+}
+
+void snw::zeroed_page_pool::push_node(page* node) {
+    nodes_.push_node(node);
+}
+
+void snw::zeroed_page_pool::run() {
+#if defined(SNW_OS_LINUX)
+    // only run when nothing else wants the cpu
+    sched_param param;
+    param.sched_priority = 0;
+    if (sched_setscheduler(0, SCHED_IDLE, &param) < 0) {
+        setpriority(PRIO_PROCESS, get_current_thread_id(), 19);
+    }
+#endif
+
+    while (running_) {
+        if (nodes_.size() >= target_size_) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait_for(lock, std::chrono::milliseconds(100), [&]() {
+                return !running_ || (nodes_.size() < (target_size_ / 2));
+            });
+            continue;
+        }
+
+        page* node = pool_.pop_node();
+        if (!node) {
+            // out of memory, try again later
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait_for(lock, std::chrono::milliseconds(100), [&]() {
+                return !running_;
+            });
+            continue;
+        }
+
+        // zero the pages referenced by the node (but not the node itself)
+        page_stack::for_each_node_page(node, [](page* page) {
+            zero_page(page);
+        });
+        _mm_sfence();
+
+        nodes_.push_node(node);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "types.h"
+#include "page.h"
+#include "page_pool.h"
+#include "concurrent_page_stack.h"
+
+namespace snw {
+
+// zero a page with non-temporal stores (so it doesn't pollute the cache)
+void zero_page(page* page);
+
+// Keeps a stock of nodes (see page_stack::detach_node) whose pages have
+// already been zeroed, topped up from a page_pool by a low priority
+// background thread. Note that the node pages themselves are not zeroed
+// since they hold the list of zeroed pages.
+class zeroed_page_pool {
+public:
+    zeroed_page_pool(page_pool& pool, size_t target_size = 4 * page_stack::max_node_size);
+    zeroed_page_pool(zeroed_page_pool&&) = delete;
+    zeroed_page_pool(const zeroed_page_pool&) = delete;
+    ~zeroed_page_pool();
+
+    zeroed_page_pool& operator=(zeroed_page_pool&&) = delete;
+    zeroed_page_pool& operator=(const zeroed_page_pool&) = delete;
+
+    // Returns nullptr if no zeroed nodes are available (it doesn't wait).
+    page* pop_node();
+
+    // Return a node whose pages are all still zeroed.
+    void push_node(page* node);
+
+    // approximate number of zeroed pages (including node pages)
+    size_t size() const {
+        return nodes_.size();
+    }
+
+private:
+    void run();
+
+private:
+    page_pool&              pool_;
+    size_t                  target_size_;
+    concurrent_page_stack   nodes_;
+
+    std::mutex              mutex_;
+    std::condition_variable cond_;
+    std::atomic<bool>       running_;
+    std::thread             thread_;
+};
+
+}
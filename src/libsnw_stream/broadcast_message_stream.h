@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "stream_buffer.h"
+
+namespace snw {
+
+enum class broadcast_mode {
+    blocking,  // the writer waits for the slowest reader (try_write fails)
+    overwrite, // the writer never waits; readers that fall behind skip ahead
+};
+
+// A message stream with a single writer and many readers, where every
+// reader sees every message (instead of copying each message into a
+// separate stream per reader).
+//
+// Each reader has its own cursor. In blocking mode the writer won't
+// overwrite anything the slowest reader hasn't read yet, and readers get a
+// reference to the message in place. In overwrite mode the writer ignores
+// the readers, so readers copy each message out and then check that the
+// writer didn't claim the space in the meantime (like a seqlock). A reader
+// that has been lapped drops everything up to the writer's position and
+// counts an overrun.
+//
+// Messages are never destroyed (there's no single owner), so they must be
+// trivially destructible.
+template<typename MessageBase>
+class broadcast_message_stream {
+private:
+    enum cursor_state {
+        cursor_free,
+        cursor_joining,
+        cursor_active,
+    };
+
+    // a cache line each, so readers don't false share with their neighbours
+    struct alignas(64) cursor {
+        std::atomic<size_t> seq;
+        std::atomic<int>    state;
+    };
+
+public:
+    class reader {
+    public:
+        // throws if the stream already has max_readers readers
+        reader(broadcast_message_stream& stream);
+        reader(reader&&) = delete;
+        reader(const reader&) = delete;
+        ~reader();
+
+        reader& operator=(reader&&) = delete;
+        reader& operator=(const reader&) = delete;
+
+        // handler is called with a const MessageBase&
+        template<typename MessageHandler>
+        size_t read(MessageHandler&& handler, size_t max_cnt = 0);
+
+        // number of times the reader was lapped by the writer (overwrite mode only)
+        size_t overruns() const {
+            return overruns_;
+        }
+
+    private:
+        broadcast_message_stream& stream_;
+        cursor&                   cursor_;
+        size_t                    rseq_;
+        size_t                    overruns_;
+        std::vector<uint64_t>     scratch_;
+    };
+
+public:
+    broadcast_message_stream(size_t min_size, size_t max_readers = 16, broadcast_mode mode = broadcast_mode::blocking);
+    broadcast_message_stream(broadcast_message_stream&&) = delete;
+    broadcast_message_stream(const broadcast_message_stream&) = delete;
+
+    broadcast_message_stream& operator=(broadcast_message_stream&&) = delete;
+    broadcast_message_stream& operator=(const broadcast_message_stream&) = delete;
+
+    broadcast_mode mode() const {
+        return mode_;
+    }
+
+    // writer only
+    template<typename Message, typename... Args>
+    bool try_write(Args&&... args);
+
+    // writer only
+    template<typename Message, typename... Args>
+    void write(Args&&... args);
+
+private:
+    cursor& subscribe();
+    size_t slowest_reader() const;
+    void* deref(size_t seq);
+
+private:
+    stream_buffer              buffer_;
+    size_t                     mask_;
+    broadcast_mode             mode_;
+    size_t                     max_readers_;
+    std::unique_ptr<uint8_t[]> cursor_storage_; // over-allocated to align the cursors
+    cursor*                    cursors_;
+
+    uint8_t                    pad0_[64];
+    size_t                     wwseq_; // writer's uncommitted wseq
+    size_t                     wrseq_; // writer's cached slowest reader
+
+    uint8_t                    pad1_[64];
+    std::atomic<size_t>        claim_; // end of the space being written (overwrite mode)
+
+    uint8_t                    pad2_[64];
+    std::atomic<size_t>        wseq_;  // end of the published messages
+
+    uint8_t                    pad3_[64];
+};
+
+}
+
+#include "broadcast_message_stream.hpp"
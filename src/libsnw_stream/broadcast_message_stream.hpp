@@ -0,0 +1,200 @@
+#pragma once
+
+#include <type_traits>
+#include <stdexcept>
+#include <new>
+#include <cstring>
+#include <cassert>
+#include "align.h"
+#include "broadcast_message_stream.h"
+
+template<typename MessageBase>
+snw::broadcast_message_stream<MessageBase>::reader::reader(broadcast_message_stream& stream)
+    : stream_(stream)
+    , cursor_(stream.subscribe())
+    , rseq_(cursor_.seq.load(std::memory_order_relaxed))
+    , overruns_(0)
+{
+}
+
+template<typename MessageBase>
+snw::broadcast_message_stream<MessageBase>::reader::~reader() {
+    cursor_.state.store(cursor_free, std::memory_order_release);
+}
+
+template<typename MessageBase>
+template<typename MessageHandler>
+size_t snw::broadcast_message_stream<MessageBase>::reader::read(MessageHandler&& handler, size_t max_cnt) {
+    const size_t size = stream_.buffer_.size();
+    const size_t wseq = stream_.wseq_.load(std::memory_order_acquire);
+
+    // special loop bounds to make max_cnt==0 act like max_cnt==infinity
+    size_t cnt = 0;
+    for (; (cnt <= (max_cnt - 1)) && (rseq_ != wseq); ++cnt) {
+        if (stream_.mode_ == broadcast_mode::blocking) {
+            size_t len;
+            const uint8_t* ptr = static_cast<const uint8_t*>(stream_.deref(rseq_));
+            memcpy(&len, ptr, sizeof(len));
+            rseq_ += len;
+
+            handler(*reinterpret_cast<const MessageBase*>(ptr + sizeof(len)));
+            continue;
+        }
+
+        if ((wseq - rseq_) > size) {
+            ++overruns_;
+            rseq_ = wseq;
+            break;
+        }
+
+        // copy the message out, then make sure the writer hasn't started
+        // overwriting it while we were copying
+        size_t len;
+        const uint8_t* ptr = static_cast<const uint8_t*>(stream_.deref(rseq_));
+        memcpy(&len, ptr, sizeof(len));
+        if (len <= size) {
+            if ((scratch_.size() * sizeof(uint64_t)) < len) {
+                scratch_.resize(align_up(len, sizeof(uint64_t)) / sizeof(uint64_t));
+            }
+            memcpy(scratch_.data(), ptr, len);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((stream_.claim_.load(std::memory_order_relaxed) - rseq_) > size) {
+            ++overruns_;
+            rseq_ = stream_.wseq_.load(std::memory_order_acquire);
+            break;
+        }
+
+        assert(len <= size);
+        rseq_ += len;
+
+        handler(*reinterpret_cast<const MessageBase*>(reinterpret_cast<const uint8_t*>(scratch_.data()) + sizeof(len)));
+    }
+
+    cursor_.seq.store(rseq_, std::memory_order_release);
+    return cnt;
+}
+
+template<typename MessageBase>
+snw::broadcast_message_stream<MessageBase>::broadcast_message_stream(size_t min_size, size_t max_readers, broadcast_mode mode)
+    : buffer_(min_size)
+    , mask_(buffer_.size() - 1)
+    , mode_(mode)
+    , max_readers_(max_readers)
+    , cursor_storage_(new uint8_t[(max_readers * sizeof(cursor)) + alignof(cursor)])
+    , cursors_(nullptr)
+    , wwseq_(0)
+    , wrseq_(0)
+    , claim_(0)
+    , wseq_(0)
+{
+    memset(pad0_, 0, sizeof(pad0_));
+    memset(pad1_, 0, sizeof(pad1_));
+    memset(pad2_, 0, sizeof(pad2_));
+    memset(pad3_, 0, sizeof(pad3_));
+
+    // new doesn't honour alignas(64) before C++17
+    cursors_ = reinterpret_cast<cursor*>(align_up(cursor_storage_.get(), alignof(cursor)));
+    for (size_t i = 0; i < max_readers_; ++i) {
+        new(&cursors_[i]) cursor();
+        cursors_[i].seq.store(0, std::memory_order_relaxed);
+        cursors_[i].state.store(cursor_free, std::memory_order_relaxed);
+    }
+}
+
+template<typename MessageBase>
+template<typename Message, typename... Args>
+bool snw::broadcast_message_stream<MessageBase>::try_write(Args&&... args) {
+    static_assert(std::is_trivially_destructible<Message>::value, "broadcast messages are never destroyed");
+
+    static constexpr size_t msg_len = align_up(sizeof(Message), alignof(size_t));
+    static constexpr size_t len = sizeof(size_t) + msg_len;
+
+    if (len > buffer_.size()) {
+        return false;
+    }
+
+    if (mode_ == broadcast_mode::blocking) {
+        // only look at the readers again when the cached position is too far behind
+        if ((buffer_.size() - (wwseq_ - wrseq_)) < len) {
+            wrseq_ = slowest_reader();
+            if ((buffer_.size() - (wwseq_ - wrseq_)) < len) {
+                return false;
+            }
+        }
+    }
+    else {
+        claim_.store(wwseq_ + len, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    uint8_t* ptr = static_cast<uint8_t*>(deref(wwseq_));
+    memcpy(ptr, &len, sizeof(len));
+    new(ptr + sizeof(len)) Message(std::forward<Args>(args)...);
+
+    wwseq_ += len;
+    wseq_.store(wwseq_, std::memory_order_release);
+    return true;
+}
+
+template<typename MessageBase>
+template<typename Message, typename... Args>
+void snw::broadcast_message_stream<MessageBase>::write(Args&&... args) {
+    if (!try_write<Message>(std::forward<Args>(args)...)) {
+        throw std::runtime_error("write failed");
+    }
+}
+
+template<typename MessageBase>
+typename snw::broadcast_message_stream<MessageBase>::cursor& snw::broadcast_message_stream<MessageBase>::subscribe() {
+    for (size_t i = 0; i < max_readers_; ++i) {
+        cursor& cursor = cursors_[i];
+
+        int state = cursor_free;
+        if (!cursor.state.compare_exchange_strong(state, cursor_joining)) {
+            continue;
+        }
+
+        // New readers only see messages written from now on. The fence pairs
+        // with the one in slowest_reader: either the writer sees this cursor
+        // joining, or we see everything the writer published before it
+        // looked at the cursors.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cursor.seq.store(wseq_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        cursor.state.store(cursor_active, std::memory_order_release);
+        return cursor;
+    }
+
+    throw std::runtime_error("too many readers");
+}
+
+template<typename MessageBase>
+size_t snw::broadcast_message_stream<MessageBase>::slowest_reader() const {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    size_t slowest = wwseq_;
+    for (size_t i = 0; i < max_readers_; ++i) {
+        const cursor& cursor = cursors_[i];
+
+        int state = cursor.state.load(std::memory_order_acquire);
+        if (state == cursor_joining) {
+            // we don't know where it will start yet, so act as if we're full
+            return wwseq_ - buffer_.size();
+        }
+
+        if (state == cursor_active) {
+            size_t seq = cursor.seq.load(std::memory_order_acquire);
+            if ((wwseq_ - seq) > (wwseq_ - slowest)) {
+                slowest = seq;
+            }
+        }
+    }
+
+    return slowest;
+}
+
+template<typename MessageBase>
+void* snw::broadcast_message_stream<MessageBase>::deref(size_t seq) {
+    return &buffer_.data()[seq & mask_];
+}
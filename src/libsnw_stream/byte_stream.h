@@ -1,13 +1,24 @@
 #pragma once
 
-#include <atomic>
 #include <cstring>
 #include <cstddef>
 #include <cstdint>
 #include "stream_buffer.h"
+#include "sequence.h"
 
 namespace snw {
 
+// A single producer single consumer byte ring. The Sequence policy (see
+// sequence.h) decides how the writer and reader publish their positions.
+//
+// By default every write_commit publishes to the reader. With a publish
+// batch of n, only every n-th commit is published (the reader sees nothing
+// of the ones in between until then), and flush publishes whatever has been
+// committed (as does a write that doesn't fit). This trades latency for
+// fewer stores to the cache line the reader polls.
+//
+// write_commit and flush return whether they published anything, so that a
+// writer only has to wake the reader when there's something new to see.
 template<typename Sequence>
 class basic_byte_stream {
 public:
@@ -21,10 +32,18 @@ public:
 public:
     size_t writable() const;
 
+    // the biggest write that can ever succeed
+    size_t max_write_size() const {
+        return buffer_.size();
+    }
+
     void write_begin();
-    void write_commit();
+    bool write_commit();
     void write_rollback();
 
+    void set_publish_batch(size_t publish_batch);
+    bool flush();
+
     template<size_t len>
     void* write();
     void* write(size_t len);
@@ -41,6 +60,7 @@ public:
     void* read(size_t len);
 
 private:
+    void publish_full();
     void* deref(size_t seq);
 
 private:
@@ -50,6 +70,9 @@ private:
     uint8_t       pad0_[64];
     size_t        wwseq_; // writer's cached wseq
     size_t        wrseq_; // writer's cached rseq
+    size_t        wcseq_; // writer's committed wseq (published or not)
+    size_t        publish_batch_;
+    size_t        unpublished_; // commits since the last publish
 
     uint8_t       pad1_[64];
     Sequence      wseq_;
@@ -62,8 +85,8 @@ private:
     Sequence      rseq_;
 };
 
-using byte_stream = basic_byte_stream<size_t>;
-using atomic_byte_stream = basic_byte_stream<std::atomic_size_t>;
+using byte_stream = basic_byte_stream<local_sequence>;
+using atomic_byte_stream = basic_byte_stream<atomic_sequence>;
 
 }
 
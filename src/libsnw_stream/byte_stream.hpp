@@ -9,6 +9,9 @@ snw::basic_byte_stream<Sequence>::basic_byte_stream(size_t min_size)
     , mask_(buffer_.size() - 1)
     , wwseq_(0)
     , wrseq_(0)
+    , wcseq_(0)
+    , publish_batch_(1)
+    , unpublished_(0)
     , wseq_(0)
     , rwseq_(0)
     , rrseq_(0)
@@ -27,23 +30,48 @@ size_t snw::basic_byte_stream<Sequence>::writable() const {
 
 template<typename Sequence>
 void snw::basic_byte_stream<Sequence>::write_begin() {
-    wrseq_ = rseq_;
+    wrseq_ = rseq_.load();
 }
 
 template<typename Sequence>
-void snw::basic_byte_stream<Sequence>::write_commit() {
-    wseq_ = wwseq_;
+bool snw::basic_byte_stream<Sequence>::write_commit() {
+    wcseq_ = wwseq_;
+    if (++unpublished_ >= publish_batch_) {
+        return flush();
+    }
+
+    return false;
 }
 
 template<typename Sequence>
 void snw::basic_byte_stream<Sequence>::write_rollback() {
-    wwseq_ = wseq_;
+    wwseq_ = wcseq_;
+}
+
+template<typename Sequence>
+void snw::basic_byte_stream<Sequence>::set_publish_batch(size_t publish_batch) {
+    publish_batch_ = (publish_batch == 0) ? 1 : publish_batch;
+    if (unpublished_ >= publish_batch_) {
+        flush();
+    }
+}
+
+template<typename Sequence>
+bool snw::basic_byte_stream<Sequence>::flush() {
+    if (unpublished_ == 0) {
+        return false;
+    }
+
+    unpublished_ = 0;
+    wseq_.store(wcseq_);
+    return true;
 }
 
 template<typename Sequence>
 template<size_t len>
 void* snw::basic_byte_stream<Sequence>::write() {
     if (writable() < len) {
+        publish_full();
         return nullptr;
     }
 
@@ -55,6 +83,7 @@ void* snw::basic_byte_stream<Sequence>::write() {
 template<typename Sequence>
 void* snw::basic_byte_stream<Sequence>::write(size_t len) {
     if (writable() < len) {
+        publish_full();
         return nullptr;
     }
 
@@ -63,6 +92,14 @@ void* snw::basic_byte_stream<Sequence>::write(size_t len) {
     return buf;
 }
 
+// A full stream has to be published, otherwise the reader can't drain it
+// and the writer would wait forever. The writer has to wake the reader
+// after a write fails for the same reason (see basic_message_stream).
+template<typename Sequence>
+void snw::basic_byte_stream<Sequence>::publish_full() {
+    flush();
+}
+
 template<typename Sequence>
 size_t snw::basic_byte_stream<Sequence>::readable() const {
     return rwseq_ - rrseq_;
@@ -70,17 +107,17 @@ size_t snw::basic_byte_stream<Sequence>::readable() const {
 
 template<typename Sequence>
 void snw::basic_byte_stream<Sequence>::read_begin() {
-    rwseq_ = wseq_;
+    rwseq_ = wseq_.load();
 }
 
 template<typename Sequence>
 void snw::basic_byte_stream<Sequence>::read_commit() {
-    rseq_ = rrseq_;
+    rseq_.store(rrseq_);
 }
 
 template<typename Sequence>
 void snw::basic_byte_stream<Sequence>::read_rollback() {
-    rrseq_ = rseq_;
+    rrseq_ = rseq_.load();
 }
 
 template<typename Sequence>
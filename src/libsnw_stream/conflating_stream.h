@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include "weak_mutex.h"
+
+namespace snw {
+
+// Maps a conflating_stream key to its slot. Integer keys (of any integral
+// type) are the slot index; anything else (e.g. a varchar) is assigned the
+// next free slot the first time it's written.
+template<typename Key, typename Enable = void>
+class conflating_key_map {
+public:
+    conflating_key_map(size_t capacity)
+        : capacity_(capacity)
+    {
+    }
+
+    // returns false if the key is new and every slot is taken
+    bool index_of(const Key& key, size_t& index) {
+        auto it = indices_.find(key);
+        if (it == indices_.end()) {
+            if (indices_.size() == capacity_) {
+                return false;
+            }
+
+            it = indices_.emplace(key, indices_.size()).first;
+        }
+
+        index = it->second;
+        return true;
+    }
+
+private:
+    size_t                          capacity_;
+    std::unordered_map<Key, size_t> indices_;
+};
+
+template<typename Key>
+class conflating_key_map<Key, typename std::enable_if<std::is_integral<Key>::value>::type> {
+public:
+    conflating_key_map(size_t capacity)
+        : capacity_(capacity)
+    {
+    }
+
+    bool index_of(Key key, size_t& index) {
+        if (std::is_signed<Key>::value && (key < static_cast<Key>(0))) {
+            return false;
+        }
+
+        index = static_cast<size_t>(key);
+        return index < capacity_;
+    }
+
+private:
+    size_t capacity_;
+};
+
+// Keeps the latest value per key, for consumers that only care about the
+// current state (e.g. the top of book per instrument). The writer overwrites
+// a key's slot in place and marks it in a dirty bitset, and the reader
+// drains only the keys that changed since it last looked, so a slow reader
+// skips the stale values instead of falling further behind.
+//
+// Slots are guarded by a weak_mutex (a seqlock): the writer never waits, and
+// the reader retries a copy that raced with a write. Single writer, single
+// reader. T must be trivially copyable, and should carry its own key if the
+// reader needs it.
+template<typename T, typename Key = size_t>
+class conflating_stream {
+    static_assert(std::is_trivially_copyable<T>::value, "conflating_stream values must be trivially copyable");
+
+public:
+    conflating_stream(size_t capacity);
+    conflating_stream(conflating_stream&&) = delete;
+    conflating_stream(const conflating_stream&) = delete;
+
+    conflating_stream& operator=(conflating_stream&&) = delete;
+    conflating_stream& operator=(const conflating_stream&) = delete;
+
+    // maximum number of keys
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    // Returns false if the key doesn't fit (an integer key out of range, or
+    // a new key when every slot is taken).
+    bool try_write(const Key& key, const T& value);
+    void write(const Key& key, const T& value);
+
+    // Calls handler(const T&) with the latest value of each key that was
+    // written since it was last read (like basic_message_stream::read).
+    template<typename ValueHandler>
+    size_t read(ValueHandler&& handler, size_t max_cnt = 0);
+
+private:
+    struct slot {
+        weak_mutex mutex;
+        T          value;
+    };
+
+    static constexpr size_t bits_per_word = 64;
+
+    void mark_dirty(size_t index);
+    // returns the version that was copied
+    int64_t copy(slot& slot, T& value);
+
+private:
+    size_t                                   capacity_;
+    size_t                                   word_count_;
+    std::unique_ptr<slot[]>                  slots_;
+    std::unique_ptr<std::atomic<uint64_t>[]> dirty_;
+    std::unique_ptr<int64_t[]>               read_versions_; // reader only, the last version of each slot read
+    conflating_key_map<Key>                  keys_; // writer only
+    size_t                                   next_word_; // reader only, where the last read stopped
+};
+
+}
+
+#include "conflating_stream.hpp"
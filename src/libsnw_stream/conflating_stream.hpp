@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stdexcept>
+#include <thread>
+#include <cstring>
+#include <cassert>
+#include "bits.h"
+#include "conflating_stream.h"
+
+template<typename T, typename Key>
+snw::conflating_stream<T, Key>::conflating_stream(size_t capacity)
+    : capacity_(capacity)
+    , word_count_((capacity + bits_per_word - 1) / bits_per_word)
+    , slots_(new slot[capacity])
+    , dirty_(new std::atomic<uint64_t>[word_count_])
+    , read_versions_(new int64_t[capacity])
+    , keys_(capacity)
+    , next_word_(0)
+{
+    if (capacity == 0) {
+        throw std::runtime_error("bad conflating_stream capacity");
+    }
+
+    for (size_t i = 0; i < word_count_; ++i) {
+        dirty_[i].store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+        read_versions_[i] = 0;
+    }
+}
+
+template<typename T, typename Key>
+bool snw::conflating_stream<T, Key>::try_write(const Key& key, const T& value) {
+    size_t index;
+    if (!keys_.index_of(key, index)) {
+        return false;
+    }
+
+    slot& slot = slots_[index];
+    slot.mutex.lock();
+    memcpy(&slot.value, &value, sizeof(T));
+    slot.mutex.unlock();
+
+    mark_dirty(index);
+    return true;
+}
+
+template<typename T, typename Key>
+void snw::conflating_stream<T, Key>::write(const Key& key, const T& value) {
+    if (!try_write(key, value)) {
+        throw std::runtime_error("write failed");
+    }
+}
+
+template<typename T, typename Key>
+template<typename ValueHandler>
+size_t snw::conflating_stream<T, Key>::read(ValueHandler&& handler, size_t max_cnt) {
+    size_t cnt = 0;
+
+    // pick up where the last read stopped, so a max_cnt can't starve the high keys
+    for (size_t i = 0; (i < word_count_) && ((max_cnt == 0) || (cnt < max_cnt)); ++i) {
+        size_t word = next_word_;
+        uint64_t bits = dirty_[word].exchange(0);
+
+        while (bits) {
+            if ((max_cnt != 0) && (cnt == max_cnt)) {
+                // hand the rest back for next time
+                dirty_[word].fetch_or(bits);
+                return cnt;
+            }
+
+            int bit = count_trailing_zeros(bits);
+            clear_bit(bits, bit);
+
+            // a write that raced with the last read may already have been seen
+            size_t index = (word * bits_per_word) + bit;
+            T value;
+            int64_t version = copy(slots_[index], value);
+            if (version == read_versions_[index]) {
+                continue;
+            }
+
+            read_versions_[index] = version;
+            ++cnt;
+
+            try {
+                handler(static_cast<const T&>(value));
+            }
+            catch (...) {
+                // the value that threw counts as read
+                dirty_[word].fetch_or(bits);
+                throw;
+            }
+        }
+
+        next_word_ = (word + 1 == word_count_) ? 0 : (word + 1);
+    }
+
+    return cnt;
+}
+
+// Checking first saves the read-modify-write while the reader is behind. If
+// the bit is already set, the reader hasn't taken it yet (the exchange is
+// ordered after our unlock), so it will see this value.
+template<typename T, typename Key>
+void snw::conflating_stream<T, Key>::mark_dirty(size_t index) {
+    std::atomic<uint64_t>& word = dirty_[index / bits_per_word];
+    uint64_t bit = 0;
+    set_bit(bit, static_cast<int>(index % bits_per_word));
+
+    if (!(word.load() & bit)) {
+        word.fetch_or(bit);
+    }
+}
+
+template<typename T, typename Key>
+int64_t snw::conflating_stream<T, Key>::copy(slot& slot, T& value) {
+    for (;;) {
+        weak_lock lock(slot.mutex);
+        if (!lock.is_locked()) {
+            std::this_thread::yield(); // mid write
+            continue;
+        }
+
+        memcpy(&value, &slot.value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (lock.is_quiescent()) {
+            return lock.version();
+        }
+    }
+}
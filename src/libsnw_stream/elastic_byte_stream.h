@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+#include "stream_buffer.h"
+#include "sequence.h"
+
+namespace snw {
+
+// A basic_byte_stream that grows instead of filling up. The writer starts
+// a ring twice the size (or big enough for the write) and moves on to it
+// when the current ring is more than grow_threshold full at write_begin, or
+// when the first write of a transaction doesn't fit. The old ring is sealed
+// by linking it to the new one; the reader drains it, follows the link and
+// frees it, so nothing is lost or reordered.
+//
+// A transaction never spans rings, so only its first write can grow the
+// stream (later writes that don't fit fail like they do in a byte_stream).
+// Writing each frame with a single write (as basic_message_stream does)
+// means writes only fail at max_size.
+template<typename Sequence>
+class basic_elastic_byte_stream {
+public:
+    static constexpr size_t unlimited = std::numeric_limits<size_t>::max();
+
+    basic_elastic_byte_stream(size_t min_size, size_t max_size = unlimited, double grow_threshold = 0.75);
+    basic_elastic_byte_stream(basic_elastic_byte_stream&&) = delete;
+    basic_elastic_byte_stream(const basic_elastic_byte_stream&) = delete;
+    ~basic_elastic_byte_stream();
+
+    basic_elastic_byte_stream& operator=(basic_elastic_byte_stream&&) = delete;
+    basic_elastic_byte_stream& operator=(const basic_elastic_byte_stream&) = delete;
+
+    // size of the writer's ring
+    size_t capacity() const;
+
+public:
+    size_t writable() const;
+
+    // the biggest write that can ever succeed (into the biggest ring that
+    // max_size allows)
+    size_t max_write_size() const;
+
+    void write_begin();
+    bool write_commit(); // always publishes
+    void write_rollback();
+
+    template<size_t len>
+    void* write();
+    void* write(size_t len);
+
+public:
+    size_t readable() const;
+
+    void read_begin();
+    void read_commit();
+    void read_rollback();
+
+    template<size_t len>
+    void* read();
+    void* read(size_t len);
+
+private:
+    struct segment {
+        segment(size_t min_size)
+            : buffer(min_size)
+            , mask(buffer.size() - 1)
+            , wseq(0)
+            , next(nullptr)
+            , rseq(0)
+        {
+        }
+
+        stream_buffer         buffer;
+        size_t                mask;
+
+        uint8_t               pad0[64];
+        Sequence              wseq;
+
+        // set by the writer once it has moved on (wseq is final by then)
+        std::atomic<segment*> next;
+
+        uint8_t               pad1[64];
+        Sequence              rseq;
+        uint8_t               pad2[64];
+    };
+
+    bool grow(size_t len);
+    void* deref(segment* seg, size_t seq);
+
+private:
+    size_t   max_size_;
+    double   grow_threshold_;
+
+    uint8_t  pad0_[64];
+    segment* wseg_;
+    size_t   wgrow_;  // grow at write_begin beyond this many bytes
+    size_t   wwseq_;  // writer's cached wseq
+    size_t   wrseq_;  // writer's cached rseq
+    size_t   wcseq_;  // writer's committed wseq
+
+    uint8_t  pad1_[64];
+    segment* rseg_;
+    size_t   rwseq_;  // reader's cached wseq
+    size_t   rrseq_;  // reader's cached rseq
+};
+
+using elastic_byte_stream = basic_elastic_byte_stream<local_sequence>;
+using atomic_elastic_byte_stream = basic_elastic_byte_stream<atomic_sequence>;
+
+}
+
+#include "elastic_byte_stream.hpp"
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+#include "elastic_byte_stream.h"
+
+template<typename Sequence>
+snw::basic_elastic_byte_stream<Sequence>::basic_elastic_byte_stream(size_t min_size, size_t max_size, double grow_threshold)
+    : max_size_(max_size)
+    , grow_threshold_(grow_threshold)
+    , wseg_(nullptr)
+    , wgrow_(0)
+    , wwseq_(0)
+    , wrseq_(0)
+    , wcseq_(0)
+    , rseg_(nullptr)
+    , rwseq_(0)
+    , rrseq_(0)
+{
+    if ((grow_threshold <= 0.0) || (grow_threshold > 1.0)) {
+        throw std::runtime_error("bad elastic_byte_stream grow threshold");
+    }
+
+    memset(pad0_, 0, sizeof(pad0_));
+    memset(pad1_, 0, sizeof(pad1_));
+
+    wseg_ = new segment(min_size);
+    wgrow_ = static_cast<size_t>(wseg_->buffer.size() * grow_threshold_);
+    rseg_ = wseg_;
+}
+
+template<typename Sequence>
+snw::basic_elastic_byte_stream<Sequence>::~basic_elastic_byte_stream() {
+    while (segment* seg = rseg_) {
+        rseg_ = seg->next.load(std::memory_order_relaxed);
+        delete seg;
+    }
+}
+
+template<typename Sequence>
+size_t snw::basic_elastic_byte_stream<Sequence>::capacity() const {
+    return wseg_->buffer.size();
+}
+
+template<typename Sequence>
+size_t snw::basic_elastic_byte_stream<Sequence>::writable() const {
+    return wseg_->buffer.size() - (wwseq_ - wrseq_);
+}
+
+template<typename Sequence>
+size_t snw::basic_elastic_byte_stream<Sequence>::max_write_size() const {
+    // rings double in size (see grow)
+    size_t size = wseg_->buffer.size();
+    while (size <= (max_size_ / 2)) {
+        size *= 2;
+    }
+
+    return size;
+}
+
+template<typename Sequence>
+void snw::basic_elastic_byte_stream<Sequence>::write_begin() {
+    wrseq_ = wseg_->rseq.load();
+
+    // grow early, so that a burst doesn't have to wait for a full ring
+    if ((wcseq_ - wrseq_) > wgrow_) {
+        grow(0);
+    }
+}
+
+template<typename Sequence>
+bool snw::basic_elastic_byte_stream<Sequence>::write_commit() {
+    wcseq_ = wwseq_;
+    wseg_->wseq.store(wcseq_);
+    return true;
+}
+
+template<typename Sequence>
+void snw::basic_elastic_byte_stream<Sequence>::write_rollback() {
+    wwseq_ = wcseq_;
+}
+
+template<typename Sequence>
+template<size_t len>
+void* snw::basic_elastic_byte_stream<Sequence>::write() {
+    return write(len);
+}
+
+template<typename Sequence>
+void* snw::basic_elastic_byte_stream<Sequence>::write(size_t len) {
+    if (writable() < len) {
+        // only an empty transaction can move to a new ring
+        if ((wwseq_ != wcseq_) || !grow(len)) {
+            return nullptr;
+        }
+    }
+
+    void* buf = deref(wseg_, wwseq_);
+    wwseq_ += len;
+    return buf;
+}
+
+// Start a new ring at least twice the size (and big enough for len bytes),
+// and seal the current one by linking to it. The reader frees the old ring
+// once it has drained it.
+template<typename Sequence>
+bool snw::basic_elastic_byte_stream<Sequence>::grow(size_t len) {
+    assert(wwseq_ == wcseq_);
+
+    size_t size = wseg_->buffer.size();
+    size_t new_size = std::max(size * 2, len);
+    if ((size >= max_size_) || (len > max_size_)) {
+        return false;
+    }
+    new_size = std::min(new_size, max_size_);
+
+    segment* seg = new segment(new_size);
+    if (seg->buffer.size() > max_size_) {
+        // the ring was rounded up past the limit
+        delete seg;
+        return false;
+    }
+
+    // everything committed has already been published to the old ring
+    wseg_->next.store(seg, std::memory_order_release);
+
+    wseg_ = seg;
+    wgrow_ = static_cast<size_t>(seg->buffer.size() * grow_threshold_);
+    wwseq_ = 0;
+    wrseq_ = 0;
+    wcseq_ = 0;
+    return true;
+}
+
+template<typename Sequence>
+size_t snw::basic_elastic_byte_stream<Sequence>::readable() const {
+    return rwseq_ - rrseq_;
+}
+
+template<typename Sequence>
+void snw::basic_elastic_byte_stream<Sequence>::read_begin() {
+    rwseq_ = rseg_->wseq.load();
+
+    // follow the writer to its new ring once the old one is drained
+    while (rwseq_ == rrseq_) {
+        segment* next = rseg_->next.load(std::memory_order_acquire);
+        if (!next) {
+            break;
+        }
+
+        // the writer may have committed more before it moved on
+        rwseq_ = rseg_->wseq.load();
+        if (rwseq_ != rrseq_) {
+            break;
+        }
+
+        delete rseg_;
+        rseg_ = next;
+        rrseq_ = 0;
+        rwseq_ = rseg_->wseq.load();
+    }
+}
+
+template<typename Sequence>
+void snw::basic_elastic_byte_stream<Sequence>::read_commit() {
+    rseg_->rseq.store(rrseq_);
+}
+
+template<typename Sequence>
+void snw::basic_elastic_byte_stream<Sequence>::read_rollback() {
+    rrseq_ = rseg_->rseq.load();
+}
+
+template<typename Sequence>
+template<size_t len>
+void* snw::basic_elastic_byte_stream<Sequence>::read() {
+    return read(len);
+}
+
+template<typename Sequence>
+void* snw::basic_elastic_byte_stream<Sequence>::read(size_t len) {
+    if (readable() < len) {
+        return nullptr;
+    }
+
+    void* buf = deref(rseg_, rrseq_);
+    rrseq_ += len;
+    return buf;
+}
+
+template<typename Sequence>
+void* snw::basic_elastic_byte_stream<Sequence>::deref(segment* seg, size_t seq) {
+    return &seg->buffer.data()[seq & seg->mask];
+}
@@ -0,0 +1,281 @@
+#include "journal.h"
+#include "align.h"
+#include "platform.h"
+#include <stdexcept>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+
+#if defined(SNW_OS_UNIX)
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+constexpr uint64_t snw::journal_segment_header::magic_value;
+constexpr uint32_t snw::journal_segment_header::version_value;
+constexpr size_t snw::journal_writer::default_segment_size;
+
+std::string snw::journal_segment_path(const char* directory, uint64_t index) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%08llu.journal", static_cast<unsigned long long>(index));
+    return std::string(directory) + name;
+}
+
+#if defined(SNW_OS_UNIX)
+
+snw::journal_writer::journal_writer(const char* directory, size_t segment_size)
+    : directory_(directory)
+    , segment_size_(align_up(segment_size, static_cast<size_t>(4096)))
+    , index_(0)
+    , data_(nullptr)
+    , offset_(0)
+{
+    if (segment_size_ <= (sizeof(journal_segment_header) + sizeof(journal_record_header))) {
+        throw std::runtime_error("bad journal segment size");
+    }
+
+    // carry on after the existing segments
+    uint64_t index = 0;
+    while (access(journal_segment_path(directory, index).c_str(), F_OK) == 0) {
+        ++index;
+    }
+
+    open_segment(index);
+}
+
+snw::journal_writer::~journal_writer() {
+    close_segment();
+}
+
+void snw::journal_writer::append(const void* data, size_t len) {
+    using namespace std::chrono;
+    uint64_t timestamp = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+    append(data, len, timestamp);
+}
+
+void snw::journal_writer::append(const void* data, size_t len, uint64_t timestamp) {
+    if (len == 0) {
+        return;
+    }
+
+    if (len > max_record_size()) {
+        throw std::runtime_error("journal record too large");
+    }
+
+    size_t record_len = sizeof(journal_record_header) + align_up(len, static_cast<size_t>(8));
+
+    // leave room for the zero record that marks the end
+    if ((segment_size_ - offset_) < (record_len + sizeof(journal_record_header))) {
+        close_segment();
+        open_segment(index_ + 1);
+    }
+
+    journal_record_header header;
+    header.timestamp = timestamp;
+    header.len = len;
+    memcpy(data_ + offset_, &header, sizeof(header));
+    memcpy(data_ + offset_ + sizeof(header), data, len);
+    offset_ += record_len;
+}
+
+void snw::journal_writer::open_segment(uint64_t index) {
+    std::string path = journal_segment_path(directory_.c_str(), index);
+
+    int fd = open(path.c_str(), O_RDWR|O_CREAT|O_EXCL, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("failed to create journal segment - open");
+    }
+
+    // Preallocate the whole segment so that appending never has to wait for
+    // the filesystem to find blocks. Not every filesystem supports that (and
+    // posix_fallocate would emulate it by writing zeros), so fall back to a
+    // sparse file.
+    bool allocated = false;
+#if defined(SNW_OS_LINUX)
+    allocated = (fallocate(fd, 0, 0, segment_size_) == 0);
+#endif
+    if (!allocated && (ftruncate(fd, segment_size_) < 0)) {
+        close(fd);
+        throw std::runtime_error("failed to create journal segment - ftruncate");
+    }
+
+    void* addr = mmap(nullptr, segment_size_, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("failed to create journal segment - mmap");
+    }
+
+    journal_segment_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = journal_segment_header::magic_value;
+    header.version = journal_segment_header::version_value;
+    header.index = index;
+    header.size = segment_size_;
+    memcpy(addr, &header, sizeof(header));
+
+    index_ = index;
+    data_ = static_cast<uint8_t*>(addr);
+    offset_ = sizeof(header);
+}
+
+void snw::journal_writer::close_segment() {
+    if (data_) {
+        int rc;
+        rc = munmap(data_, segment_size_);
+        assert(rc >= 0);
+
+        data_ = nullptr;
+        offset_ = 0;
+    }
+}
+
+snw::journal_reader::journal_reader(const char* directory, uint64_t first_index)
+    : directory_(directory)
+    , index_(first_index)
+    , data_(nullptr)
+    , size_(0)
+    , offset_(0)
+{
+    if (!open_segment(first_index)) {
+        throw std::runtime_error("failed to open journal");
+    }
+}
+
+snw::journal_reader::~journal_reader() {
+    close_segment();
+}
+
+bool snw::journal_reader::next(journal_record& record) {
+    while (data_) {
+        if ((offset_ + sizeof(journal_record_header)) <= size_) {
+            journal_record_header header;
+            memcpy(&header, data_ + offset_, sizeof(header));
+
+            size_t record_len = sizeof(header) + align_up(static_cast<size_t>(header.len), static_cast<size_t>(8));
+            if ((header.len != 0) && (record_len <= (size_ - offset_))) {
+                record.timestamp = header.timestamp;
+                record.data = span<const uint8_t>(data_ + offset_ + sizeof(header), header.len);
+                offset_ += record_len;
+                return true;
+            }
+        }
+
+        // the end of this segment, carry on with the next one (if any)
+        close_segment();
+        open_segment(index_ + 1);
+    }
+
+    return false;
+}
+
+bool snw::journal_reader::open_segment(uint64_t index) {
+    std::string path = journal_segment_path(directory_.c_str(), index);
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if ((fstat(fd, &st) < 0) || (static_cast<size_t>(st.st_size) < sizeof(journal_segment_header))) {
+        close(fd);
+        throw std::runtime_error("failed to open journal segment - bad size");
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("failed to open journal segment - mmap");
+    }
+
+    journal_segment_header header;
+    memcpy(&header, addr, sizeof(header));
+    if ((header.magic != journal_segment_header::magic_value) ||
+        (header.version != journal_segment_header::version_value) ||
+        (header.index != index)) {
+        munmap(addr, size);
+        throw std::runtime_error("failed to open journal segment - bad header");
+    }
+
+    // the pages are read front to back
+    madvise(addr, size, MADV_SEQUENTIAL);
+
+    index_ = index;
+    data_ = static_cast<const uint8_t*>(addr);
+    size_ = size;
+    offset_ = sizeof(header);
+    return true;
+}
+
+void snw::journal_reader::close_segment() {
+    if (data_) {
+        int rc;
+        rc = munmap(const_cast<uint8_t*>(data_), size_);
+        assert(rc >= 0);
+
+        data_ = nullptr;
+        size_ = 0;
+        offset_ = 0;
+    }
+}
+
+#else
+
+snw::journal_writer::journal_writer(const char* directory, size_t segment_size)
+    : directory_(directory)
+    , segment_size_(segment_size)
+    , index_(0)
+    , data_(nullptr)
+    , offset_(0)
+{
+    throw std::runtime_error("not implemented");
+}
+
+snw::journal_writer::~journal_writer() {
+}
+
+void snw::journal_writer::append(const void* data, size_t len) {
+    throw std::runtime_error("not implemented");
+}
+
+void snw::journal_writer::append(const void* data, size_t len, uint64_t timestamp) {
+    throw std::runtime_error("not implemented");
+}
+
+void snw::journal_writer::open_segment(uint64_t index) {
+    throw std::runtime_error("not implemented");
+}
+
+void snw::journal_writer::close_segment() {
+}
+
+snw::journal_reader::journal_reader(const char* directory, uint64_t first_index)
+    : directory_(directory)
+    , index_(first_index)
+    , data_(nullptr)
+    , size_(0)
+    , offset_(0)
+{
+    throw std::runtime_error("not implemented");
+}
+
+snw::journal_reader::~journal_reader() {
+}
+
+bool snw::journal_reader::next(journal_record& record) {
+    throw std::runtime_error("not implemented");
+}
+
+bool snw::journal_reader::open_segment(uint64_t index) {
+    throw std::runtime_error("not implemented");
+}
+
+void snw::journal_reader::close_segment() {
+}
+
+#endif
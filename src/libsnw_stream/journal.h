@@ -0,0 +1,113 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "span.h"
+
+namespace snw {
+
+// Journals are a directory of segment files named 00000000.journal,
+// 00000001.journal, ... Each segment is preallocated to a fixed size and
+// starts with a journal_segment_header, followed by records. A record is a
+// journal_record_header followed by len bytes (padded to 8 bytes). The rest
+// of a segment is zero, so a record with len == 0 marks the end.
+struct journal_segment_header {
+    static constexpr uint64_t magic_value = 0x314c4e524a574e53; // "SNWJRNL1"
+    static constexpr uint32_t version_value = 1;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t index;
+    uint64_t size;
+    uint8_t  pad[32];
+};
+static_assert(sizeof(journal_segment_header) == 64, "");
+
+struct journal_record_header {
+    uint64_t timestamp; // nanoseconds since the epoch
+    uint64_t len;
+};
+
+// path of segment index in directory
+std::string journal_segment_path(const char* directory, uint64_t index);
+
+// Appends records to memory-mapped segment files. Appending is a memcpy
+// into the current segment; the only syscalls are when a segment fills up
+// and the next one is created and mapped.
+class journal_writer {
+public:
+    static constexpr size_t default_segment_size = 64 * 1024 * 1024;
+
+    // Starts a new segment after any that are already in directory (which
+    // must exist). segment_size is rounded up to a whole number of pages.
+    journal_writer(const char* directory, size_t segment_size = default_segment_size);
+    journal_writer(journal_writer&&) = delete;
+    journal_writer(const journal_writer&) = delete;
+    ~journal_writer();
+
+    journal_writer& operator=(journal_writer&&) = delete;
+    journal_writer& operator=(const journal_writer&) = delete;
+
+    // Append one record, rolling to a new segment if it doesn't fit.
+    // Throws if the record could never fit in a segment.
+    void append(const void* data, size_t len);
+    void append(const void* data, size_t len, uint64_t timestamp);
+
+    // the longest record that fits in a segment (with its end marker)
+    size_t max_record_size() const {
+        return segment_size_ - sizeof(journal_segment_header) - (2 * sizeof(journal_record_header));
+    }
+
+    // the index of the current segment
+    uint64_t segment_index() const {
+        return index_;
+    }
+
+private:
+    void open_segment(uint64_t index);
+    void close_segment();
+
+private:
+    std::string directory_;
+    size_t      segment_size_;
+    uint64_t    index_;
+    uint8_t*    data_;   // the mapped segment
+    size_t      offset_; // where the next record goes
+};
+
+struct journal_record {
+    uint64_t            timestamp;
+    span<const uint8_t> data;
+};
+
+// Reads the records of a journal in order, one segment mapped at a time.
+class journal_reader {
+public:
+    // throws if the first segment doesn't exist
+    journal_reader(const char* directory, uint64_t first_index = 0);
+    journal_reader(journal_reader&&) = delete;
+    journal_reader(const journal_reader&) = delete;
+    ~journal_reader();
+
+    journal_reader& operator=(journal_reader&&) = delete;
+    journal_reader& operator=(const journal_reader&) = delete;
+
+    // Returns false at the end of the journal. The record's data stays
+    // valid until the reader moves to the next segment.
+    bool next(journal_record& record);
+
+private:
+    bool open_segment(uint64_t index);
+    void close_segment();
+
+private:
+    std::string    directory_;
+    uint64_t       index_;
+    const uint8_t* data_;
+    size_t         size_;
+    size_t         offset_;
+};
+
+}
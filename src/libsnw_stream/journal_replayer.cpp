@@ -0,0 +1,35 @@
+#include "journal_replayer.h"
+#include <thread>
+#include <stdexcept>
+
+snw::journal_replayer::journal_replayer(const char* directory, replay_mode mode, double speed)
+    : reader_(directory)
+    , mode_(mode)
+    , speed_((mode == replay_mode::scaled_timing) ? speed : 1.0)
+    , started_(false)
+    , first_timestamp_(0)
+{
+    if (!(speed_ > 0.0)) {
+        throw std::runtime_error("bad replay speed");
+    }
+}
+
+// Sleep until the record is due. Timing is relative to the first record,
+// and late records are released right away (so we catch up after a stall).
+void snw::journal_replayer::wait_for(uint64_t timestamp) {
+    if (mode_ == replay_mode::max_speed) {
+        return;
+    }
+
+    if (!started_) {
+        started_ = true;
+        first_timestamp_ = timestamp;
+        start_ = clock::now();
+        return;
+    }
+
+    // journal timestamps can go backwards if the wall clock is adjusted
+    uint64_t elapsed = (timestamp > first_timestamp_) ? (timestamp - first_timestamp_) : 0;
+    auto offset = std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(elapsed) / speed_));
+    std::this_thread::sleep_until(start_ + std::chrono::duration_cast<clock::duration>(offset));
+}
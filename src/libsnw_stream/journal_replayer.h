@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "span.h"
+#include "journal.h"
+
+namespace snw {
+
+enum class replay_mode {
+    max_speed,       // as fast as the consumer can take it
+    original_timing, // records are spaced out like they were recorded
+    scaled_timing,   // like original_timing, but speed times faster
+};
+
+// Replays a journal written by journal_writer (from a message_stream
+// tee). Each record holds one or more framed messages (the tee writes one
+// per message); records are released according to the replay_mode and
+// their messages are either handed to a handler or written into another
+// message stream.
+class journal_replayer {
+public:
+    journal_replayer(const char* directory, replay_mode mode = replay_mode::max_speed, double speed = 1.0);
+    journal_replayer(journal_replayer&&) = delete;
+    journal_replayer(const journal_replayer&) = delete;
+
+    journal_replayer& operator=(journal_replayer&&) = delete;
+    journal_replayer& operator=(const journal_replayer&) = delete;
+
+    // Call handler(span<const uint8_t>) with each message payload. Returns
+    // the number of messages.
+    template<typename SpanHandler>
+    size_t replay_spans(SpanHandler&& handler);
+
+    // Call handler(const MessageBase&) with each message (which must be
+    // trivially copyable, since the journal holds a byte for byte copy).
+    template<typename MessageBase, typename MessageHandler>
+    size_t replay(MessageHandler&& handler);
+
+    // Write each message into a basic_message_stream (waiting for room when
+    // it's full). Returns the number of messages. Throws if a message is
+    // longer than the stream can ever hold.
+    template<typename MessageStream>
+    size_t replay_into(MessageStream& stream);
+
+private:
+    void wait_for(uint64_t timestamp);
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    journal_reader    reader_;
+    replay_mode       mode_;
+    double            speed_;
+    bool              started_;
+    uint64_t          first_timestamp_;
+    clock::time_point start_;
+};
+
+}
+
+#include "journal_replayer.hpp"
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <thread>
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+#include "align.h"
+#include "journal_replayer.h"
+
+template<typename SpanHandler>
+size_t snw::journal_replayer::replay_spans(SpanHandler&& handler) {
+    size_t cnt = 0;
+
+    journal_record record;
+    while (reader_.next(record)) {
+        wait_for(record.timestamp);
+
+        // the same framing as basic_message_stream
+        const uint8_t* ptr = record.data.data();
+        const uint8_t* last = ptr + record.data.size();
+        while (ptr < last) {
+            size_t len;
+            memcpy(&len, ptr, sizeof(len));
+            ptr += sizeof(len);
+            assert((ptr + len) <= last);
+
+            handler(span<const uint8_t>(ptr, len));
+            ptr += align_up(len, alignof(size_t));
+            ++cnt;
+        }
+    }
+
+    return cnt;
+}
+
+template<typename MessageBase, typename MessageHandler>
+size_t snw::journal_replayer::replay(MessageHandler&& handler) {
+    return replay_spans([&handler](span<const uint8_t> payload) {
+        handler(*reinterpret_cast<const MessageBase*>(payload.data()));
+    });
+}
+
+template<typename MessageStream>
+size_t snw::journal_replayer::replay_into(MessageStream& stream) {
+    return replay_spans([&stream](span<const uint8_t> payload) {
+        // otherwise we'd wait for room forever
+        if (payload.size() > stream.max_message_size()) {
+            throw std::runtime_error("replayed message too large");
+        }
+
+        span<uint8_t> buf;
+        while (!(buf = stream.reserve(payload.size()))) {
+            std::this_thread::yield();
+        }
+
+        memcpy(buf.data(), payload.data(), payload.size());
+        stream.commit();
+    });
+}
@@ -1,14 +1,133 @@
 #pragma once
 
+#include <iterator>
+#include <cstring>
 #include <cstddef>
+#include "span.h"
+#include "align.h"
 #include "byte_stream.h"
+#include "wait_strategy.h"
+#include "journal.h"
 
 namespace snw {
 
-template<typename MessageBase, typename Stream>
+// WaitStrategy decides how wait_read waits for messages (see wait_strategy.h).
+template<typename MessageBase, typename Stream, typename WaitStrategy = spin_wait>
 class basic_message_stream {
+public:
+    // Every message that was readable when the batch was taken, as one
+    // contiguous run of framed messages (the buffer is mirrored, so the run
+    // never wraps). Iterating only loads each message's length to find the
+    // next one, so consumers can look ahead (e.g. to prefetch) freely.
+    class batch {
+    public:
+        class iterator {
+        public:
+            using value_type = MessageBase;
+            using pointer = MessageBase*;
+            using reference = MessageBase&;
+            using difference_type = ptrdiff_t;
+            using iterator_category = std::forward_iterator_tag;
+
+            iterator()
+                : ptr_(nullptr)
+            {
+            }
+
+            reference operator*() const {
+                return *reinterpret_cast<MessageBase*>(ptr_ + sizeof(size_t));
+            }
+
+            pointer operator->() const {
+                return &**this;
+            }
+
+            // the message's payload (see reserve)
+            span<const uint8_t> payload() const {
+                return span<const uint8_t>(ptr_ + sizeof(size_t), len());
+            }
+
+            iterator& operator++() {
+                ptr_ += sizeof(size_t) + align_up(len(), alignof(size_t));
+                return *this;
+            }
+
+            iterator operator++(int) {
+                auto result = *this;
+                ++(*this);
+                return result;
+            }
+
+            bool operator==(const iterator& rhs) const {
+                return ptr_ == rhs.ptr_;
+            }
+
+            bool operator!=(const iterator& rhs) const {
+                return ptr_ != rhs.ptr_;
+            }
+
+        private:
+            friend class batch;
+
+            explicit iterator(uint8_t* ptr)
+                : ptr_(ptr)
+            {
+            }
+
+            size_t len() const {
+                size_t len;
+                memcpy(&len, ptr_, sizeof(len));
+                return len;
+            }
+
+            uint8_t* ptr_;
+        };
+
+        batch()
+            : data_(nullptr)
+            , size_(0)
+        {
+        }
+
+        iterator begin() const {
+            return iterator(data_);
+        }
+
+        iterator end() const {
+            return iterator(data_ + size_);
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        // the framed messages
+        span<const uint8_t> bytes() const {
+            return span<const uint8_t>(data_, size_);
+        }
+
+    private:
+        friend class basic_message_stream;
+
+        batch(uint8_t* data, size_t size)
+            : data_(data)
+            , size_(size)
+        {
+        }
+
+        uint8_t* data_;
+        size_t   size_;
+    };
+
 public:
     basic_message_stream(size_t min_size);
+
+    // Take over a stream that's already set up, e.g. a shared_byte_stream
+    // that was created or attached by name. Across processes the wait
+    // strategy isn't shared, so only spin_wait and yield_wait make sense,
+    // and messages are destroyed by the reader's process (so they should be
+    // trivially destructible, or at least not rely on a vtable).
+    basic_message_stream(Stream&& stream);
     basic_message_stream(basic_message_stream&&) = delete;
     basic_message_stream(const basic_message_stream&) = delete;
 
@@ -18,14 +137,71 @@ public:
     template<typename MessageHandler>
     size_t read(MessageHandler&& handler, size_t max_cnt = 0);
 
+    // like read, but waits until there's at least one message
+    template<typename MessageHandler>
+    size_t wait_read(MessageHandler&& handler, size_t max_cnt = 0);
+
     template<typename Message, typename... Args>
     bool try_write(Args&&... args);
 
     template<typename Message, typename... Args>
     void write(Args&&... args);
 
+    // Variable length messages: reserve len bytes in the stream and fill
+    // them in place, then commit (optionally shrinking the message to the
+    // first len bytes) or roll back. Returns an invalid span if there's no
+    // room. Nothing else may be written between reserve and commit.
+    span<uint8_t> reserve(size_t len);
+
+    // the longest message that can ever be written (reserve always fails
+    // beyond it)
+    size_t max_message_size() const {
+        return align_down(stream_.max_write_size() - sizeof(size_t), alignof(size_t));
+    }
+
+    void commit();
+    void commit(size_t len);
+    void rollback();
+
+    // Publish only every n-th message to the reader (see basic_byte_stream).
+    // flush publishes (and wakes the reader for) everything written so far.
+    void set_publish_batch(size_t publish_batch);
+    void flush();
+
+    // Like read, but the handler is called with a span<const uint8_t> of
+    // the payload instead of a MessageBase& (and nothing is destroyed).
+    template<typename SpanHandler>
+    size_t read_span(SpanHandler&& handler, size_t max_cnt = 0);
+
+    // Take every readable message as a batch, then commit it in one go
+    // when done with it (which destroys the messages, so like read, every
+    // message has to be a MessageBase unless it's trivially destructible).
+    // Nothing else may be read in between.
+    batch read_batch();
+    void commit_batch(const batch& messages);
+
+    // Tee every committed message into a journal (nullptr to stop), for an
+    // audit trail of the stream. Each message is appended as its own record
+    // (the framed message, see journal_replayer) on the writer's thread when
+    // it's committed, before the reader can see it. So messages that are
+    // still in the stream when the process dies are on record, but each
+    // commit pays for a memcpy into the journal's mapping (and a clock
+    // read). If the append throws, the message isn't written and the
+    // exception propagates from try_write/write/commit. The journal must
+    // outlive the stream (or be detached).
+    void set_journal(journal_writer* journal) {
+        journal_ = journal;
+    }
+
+private:
+    void journal(const uint8_t* frame);
+
 private:
-    Stream stream_;
+    Stream          stream_;
+    size_t          reserved_;
+    uint8_t*        reserved_frame_;
+    journal_writer* journal_;
+    WaitStrategy    wait_;
 };
 
 template<typename MessageBase>
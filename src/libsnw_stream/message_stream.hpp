@@ -1,20 +1,34 @@
 #pragma once
 
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <cstring>
 #include <cassert>
 #include "align.h"
 #include "message_stream.h"
 
-template<typename MessageBase, typename Stream>
-snw::basic_message_stream<MessageBase, Stream>::basic_message_stream(size_t min_size)
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::basic_message_stream(size_t min_size)
     : stream_(min_size)
+    , reserved_(0)
+    , reserved_frame_(nullptr)
+    , journal_(nullptr)
 {
 }
 
-template<typename MessageBase, typename Stream>
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::basic_message_stream(Stream&& stream)
+    : stream_(std::move(stream))
+    , reserved_(0)
+    , reserved_frame_(nullptr)
+    , journal_(nullptr)
+{
+}
+
+template<typename MessageBase, typename Stream, typename WaitStrategy>
 template<typename MessageHandler>
-size_t snw::basic_message_stream<MessageBase, Stream>::read(MessageHandler&& handler, size_t max_cnt) {
+size_t snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::read(MessageHandler&& handler, size_t max_cnt) {
     stream_.read_begin();
 
     // special loop bounds to make max_cnt==0 act like max_cnt==infinity
@@ -31,7 +45,7 @@ size_t snw::basic_message_stream<MessageBase, Stream>::read(MessageHandler&& han
         }
 
         {
-            void* ptr = stream_.read(len);
+            void* ptr = stream_.read(align_up(len, alignof(size_t)));
             assert(ptr);
 
             MessageBase& message = *reinterpret_cast<MessageBase*>(ptr);
@@ -51,44 +65,203 @@ size_t snw::basic_message_stream<MessageBase, Stream>::read(MessageHandler&& han
     return cnt;
 }
 
-template<typename MessageBase, typename Stream>
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+template<typename MessageHandler>
+size_t snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::wait_read(MessageHandler&& handler, size_t max_cnt) {
+    wait_.wait([this]() {
+        stream_.read_begin();
+        return stream_.readable() > 0;
+    });
+
+    return read(std::forward<MessageHandler>(handler), max_cnt);
+}
+
+template<typename MessageBase, typename Stream, typename WaitStrategy>
 template<typename Message, typename... Args>
-bool snw::basic_message_stream<MessageBase, Stream>::try_write(Args&&... args) {
+bool snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::try_write(Args&&... args) {
     static constexpr size_t msg_len = align_up(sizeof(Message), alignof(size_t));
 
     stream_.write_begin();
 
-    // write message length
-    {
-        size_t len = msg_len;
-        void* ptr = stream_.write<sizeof(len)>();
-        if (!ptr) {
-            stream_.write_rollback();
-            return false;
-        }
-
-        memcpy(ptr, &len, sizeof(len));
+    // the length and the message are written as one frame, so streams that
+    // can grow (see elastic_byte_stream) always keep them together
+    uint8_t* ptr = static_cast<uint8_t*>(stream_.template write<sizeof(size_t) + msg_len>());
+    if (!ptr) {
+        // a write that doesn't fit publishes whatever was batched, which a
+        // sleeping reader has to be woken for
+        stream_.write_rollback();
+        wait_.notify();
+        return false;
     }
 
-    // write message
-    {
-        void* ptr = stream_.write<msg_len>();
-        if (!ptr) {
-            stream_.write_rollback();
-            return false;
-        }
+    size_t len = msg_len;
+    memcpy(ptr, &len, sizeof(len));
+    Message* message = new(ptr + sizeof(len)) Message(std::forward<Args>(args)...);
 
-        new(ptr) Message(std::forward<Args>(args)...);
+    if (journal_) {
+        try {
+            journal(ptr);
+        }
+        catch (...) {
+            message->~Message(); // better not throw...
+            throw;
+        }
     }
 
-    stream_.write_commit();
+    if (stream_.write_commit()) {
+        wait_.notify();
+    }
     return true;
 }
 
-template<typename MessageBase, typename Stream>
+template<typename MessageBase, typename Stream, typename WaitStrategy>
 template<typename Message, typename... Args>
-void snw::basic_message_stream<MessageBase, Stream>::write(Args&&... args) {
+void snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::write(Args&&... args) {
     if (!try_write<Message>(std::forward<Args>(args)...)) {
         throw std::runtime_error("write failed");
     }
 }
+
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+snw::span<uint8_t> snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::reserve(size_t len) {
+    stream_.write_begin();
+
+    // the length prefix holds the exact payload length; the payload is padded
+    uint8_t* ptr = static_cast<uint8_t*>(stream_.write(sizeof(len) + align_up(len, alignof(size_t))));
+    if (!ptr) {
+        // see try_write
+        stream_.write_rollback();
+        wait_.notify();
+        return span<uint8_t>();
+    }
+
+    memcpy(ptr, &len, sizeof(len));
+    reserved_ = len;
+    reserved_frame_ = ptr;
+    return span<uint8_t>(ptr + sizeof(len), len);
+}
+
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+void snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::commit() {
+    if (journal_) {
+        journal(reserved_frame_);
+    }
+
+    if (stream_.write_commit()) {
+        wait_.notify();
+    }
+}
+
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+void snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::commit(size_t len) {
+    assert(len <= reserved_);
+
+    // redo the reservation at the same place with the smaller length
+    // (the payload that's already there is left alone)
+    if (len < reserved_) {
+        stream_.write_rollback();
+
+        void* ptr = stream_.write(sizeof(len) + align_up(len, alignof(size_t)));
+        assert(ptr);
+        memcpy(ptr, &len, sizeof(len));
+    }
+
+    commit();
+}
+
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+void snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::rollback() {
+    stream_.write_rollback();
+}
+
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+void snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::set_publish_batch(size_t publish_batch) {
+    stream_.set_publish_batch(publish_batch);
+}
+
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+void snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::flush() {
+    if (stream_.flush()) {
+        wait_.notify();
+    }
+}
+
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+template<typename SpanHandler>
+size_t snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::read_span(SpanHandler&& handler, size_t max_cnt) {
+    stream_.read_begin();
+
+    // special loop bounds to make max_cnt==0 act like max_cnt==infinity
+    size_t cnt = 0;
+    for (; cnt <= (max_cnt - 1); ++cnt) {
+        size_t len;
+        {
+            const void* ptr = stream_.template read<sizeof(len)>();
+            if (!ptr) {
+                break;
+            }
+
+            memcpy(&len, ptr, sizeof(len));
+        }
+
+        const void* ptr = stream_.read(align_up(len, alignof(size_t)));
+        assert(ptr);
+
+        try {
+            handler(span<const uint8_t>(static_cast<const uint8_t*>(ptr), len));
+        }
+        catch (const std::exception &) {
+            stream_.read_commit();
+            throw;
+        }
+    }
+
+    stream_.read_commit();
+    return cnt;
+}
+
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+typename snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::batch snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::read_batch() {
+    stream_.read_begin();
+
+    size_t len = stream_.readable();
+    if (len == 0) {
+        return batch();
+    }
+
+    void* ptr = stream_.read(len);
+    assert(ptr);
+    return batch(static_cast<uint8_t*>(ptr), len);
+}
+
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+void snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::commit_batch(const batch& messages) {
+    if (messages.empty()) {
+        return;
+    }
+
+    if (!std::is_trivially_destructible<MessageBase>::value) {
+        for (MessageBase& message: messages) {
+            message.~MessageBase(); // better not throw...
+        }
+    }
+
+    stream_.read_commit();
+}
+
+// Append a committed frame to the journal before it's published, so the
+// reader can't have touched it yet. If that throws, the frame is rolled
+// back (and isn't written at all).
+template<typename MessageBase, typename Stream, typename WaitStrategy>
+void snw::basic_message_stream<MessageBase, Stream, WaitStrategy>::journal(const uint8_t* frame) {
+    size_t len;
+    memcpy(&len, frame, sizeof(len));
+
+    try {
+        journal_->append(frame, sizeof(len) + align_up(len, alignof(size_t)));
+    }
+    catch (...) {
+        stream_.write_rollback();
+        throw;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "stream_buffer.h"
+
+namespace snw {
+
+// A message stream with many writers and a single reader.
+//
+// Writers reserve space for a whole message by advancing a shared write
+// sequence, construct the message in place, and then publish it by storing
+// its length into the message header (with release semantics). The reader
+// consumes messages in reservation order, stopping at the first header that
+// hasn't been published yet, and zeroes everything it consumes so that a
+// zero header always means "not yet published".
+//
+// A writer that stalls between reserving and publishing holds up the reader
+// (but not the other writers, until the buffer fills up).
+template<typename MessageBase>
+class mpsc_message_stream {
+public:
+    mpsc_message_stream(size_t min_size);
+    mpsc_message_stream(mpsc_message_stream&&) = delete;
+    mpsc_message_stream(const mpsc_message_stream&) = delete;
+
+    mpsc_message_stream& operator=(mpsc_message_stream&&) = delete;
+    mpsc_message_stream& operator=(const mpsc_message_stream&) = delete;
+
+    // reader only
+    template<typename MessageHandler>
+    size_t read(MessageHandler&& handler, size_t max_cnt = 0);
+
+    // any thread
+    template<typename Message, typename... Args>
+    bool try_write(Args&&... args);
+
+    // any thread
+    template<typename Message, typename... Args>
+    void write(Args&&... args);
+
+private:
+    using header = std::atomic<size_t>;
+    static_assert(sizeof(header) == sizeof(size_t), "");
+
+    header& header_at(size_t seq);
+    void* deref(size_t seq);
+
+private:
+    stream_buffer       buffer_;
+    size_t              mask_;
+
+    uint8_t             pad0_[64];
+    std::atomic<size_t> wseq_; // end of the reserved space
+
+    uint8_t             pad1_[64];
+    std::atomic<size_t> rseq_; // end of the consumed (and zeroed) space
+
+    uint8_t             pad2_[64];
+    size_t              rrseq_; // reader's uncommitted rseq
+
+    uint8_t             pad3_[64];
+};
+
+}
+
+#include "mpsc_message_stream.hpp"
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+#include "align.h"
+#include "mpsc_message_stream.h"
+
+template<typename MessageBase>
+snw::mpsc_message_stream<MessageBase>::mpsc_message_stream(size_t min_size)
+    : buffer_(min_size)
+    , mask_(buffer_.size() - 1)
+    , wseq_(0)
+    , rseq_(0)
+    , rrseq_(0)
+{
+    memset(pad0_, 0, sizeof(pad0_));
+    memset(pad1_, 0, sizeof(pad1_));
+    memset(pad2_, 0, sizeof(pad2_));
+    memset(pad3_, 0, sizeof(pad3_));
+
+    // a fresh buffer is all zeroes, i.e. nothing published
+    assert(header_at(0).load(std::memory_order_relaxed) == 0);
+}
+
+template<typename MessageBase>
+template<typename MessageHandler>
+size_t snw::mpsc_message_stream<MessageBase>::read(MessageHandler&& handler, size_t max_cnt) {
+    // special loop bounds to make max_cnt==0 act like max_cnt==infinity
+    size_t cnt = 0;
+    for (; cnt <= (max_cnt - 1); ++cnt) {
+        size_t len = header_at(rrseq_).load(std::memory_order_acquire);
+        if (len == 0) {
+            break;
+        }
+
+        void* record = deref(rrseq_);
+        rrseq_ += len;
+
+        MessageBase& message = *reinterpret_cast<MessageBase*>(static_cast<uint8_t*>(record) + sizeof(header));
+        try {
+            handler(message);
+            message.~MessageBase(); // better not throw...
+            memset(record, 0, len);
+        }
+        catch (const std::exception &) {
+            message.~MessageBase(); // better not throw...
+            memset(record, 0, len);
+            rseq_.store(rrseq_, std::memory_order_release);
+            throw;
+        }
+    }
+
+    // hand the zeroed space back to the writers
+    rseq_.store(rrseq_, std::memory_order_release);
+    return cnt;
+}
+
+template<typename MessageBase>
+template<typename Message, typename... Args>
+bool snw::mpsc_message_stream<MessageBase>::try_write(Args&&... args) {
+    static constexpr size_t msg_len = align_up(sizeof(Message), alignof(size_t));
+    static constexpr size_t len = sizeof(header) + msg_len;
+
+    // A plain fetch_add would let writers reserve past the reader when the
+    // buffer is full, so only reserve when the whole message fits.
+    size_t seq = wseq_.load(std::memory_order_relaxed);
+    do {
+        size_t rseq = rseq_.load(std::memory_order_acquire);
+        if ((buffer_.size() - (seq - rseq)) < len) {
+            return false;
+        }
+    } while (!wseq_.compare_exchange_weak(seq, seq + len, std::memory_order_relaxed));
+
+    new(static_cast<uint8_t*>(deref(seq)) + sizeof(header)) Message(std::forward<Args>(args)...);
+
+    header_at(seq).store(len, std::memory_order_release);
+    return true;
+}
+
+template<typename MessageBase>
+template<typename Message, typename... Args>
+void snw::mpsc_message_stream<MessageBase>::write(Args&&... args) {
+    if (!try_write<Message>(std::forward<Args>(args)...)) {
+        throw std::runtime_error("write failed");
+    }
+}
+
+template<typename MessageBase>
+typename snw::mpsc_message_stream<MessageBase>::header& snw::mpsc_message_stream<MessageBase>::header_at(size_t seq) {
+    return *reinterpret_cast<header*>(deref(seq));
+}
+
+template<typename MessageBase>
+void* snw::mpsc_message_stream<MessageBase>::deref(size_t seq) {
+    return &buffer_.data()[seq & mask_];
+}
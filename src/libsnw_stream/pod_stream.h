@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "stream_buffer.h"
+#include "sequence.h"
+
+namespace snw {
+
+// A stream of a single trivially copyable type. Unlike basic_message_stream
+// there's no length prefix: the ring is an array of T (packed, so slots of
+// a power of 2 size never straddle a cache line), and sequences count
+// items rather than bytes.
+//
+// Because the ring is mirrored, any run of items is contiguous, so bulk
+// reads and writes are a single memcpy (which is vectorized) followed by a
+// single sequence publish. Sequence is a policy from sequence.h.
+template<typename T, typename Sequence>
+class basic_pod_stream {
+    static_assert(std::is_trivially_copyable<T>::value, "pod_stream items must be trivially copyable");
+
+public:
+    basic_pod_stream(size_t min_capacity);
+    basic_pod_stream(basic_pod_stream&&) = delete;
+    basic_pod_stream(const basic_pod_stream&) = delete;
+
+    basic_pod_stream& operator=(basic_pod_stream&&) = delete;
+    basic_pod_stream& operator=(const basic_pod_stream&) = delete;
+
+    // maximum number of items in the stream
+    size_t capacity() const {
+        return capacity_;
+    }
+
+public:
+    bool try_write(const T& item);
+
+    // writes as many of the items as fit, returns the number written
+    size_t write_n(const T* items, size_t cnt);
+
+public:
+    bool try_read(T& item);
+
+    // reads up to cnt items, returns the number read
+    size_t read_n(T* items, size_t cnt);
+
+    // calls handler(const T&) for each item in place
+    template<typename ItemHandler>
+    size_t read(ItemHandler&& handler, size_t max_cnt = 0);
+
+private:
+    size_t writable(size_t wanted);
+    size_t readable(size_t wanted);
+    T* deref(size_t seq);
+
+private:
+    stream_buffer buffer_;
+    size_t        capacity_;
+
+    uint8_t       pad0_[64];
+    size_t        wwseq_; // writer's cached wseq
+    size_t        wrseq_; // writer's cached rseq
+
+    uint8_t       pad1_[64];
+    Sequence      wseq_;
+
+    uint8_t       pad2_[64];
+    size_t        rwseq_; // reader's cached wseq
+    size_t        rrseq_; // reader's cached rseq
+
+    uint8_t       pad3_[64];
+    Sequence      rseq_;
+};
+
+template<typename T>
+using pod_stream = basic_pod_stream<T, local_sequence>;
+
+template<typename T>
+using atomic_pod_stream = basic_pod_stream<T, atomic_sequence>;
+
+}
+
+#include "pod_stream.hpp"
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cassert>
+#include "pod_stream.h"
+
+template<typename T, typename Sequence>
+snw::basic_pod_stream<T, Sequence>::basic_pod_stream(size_t min_capacity)
+    : buffer_(min_capacity * sizeof(T))
+    , capacity_(buffer_.size() / sizeof(T))
+    , wwseq_(0)
+    , wrseq_(0)
+    , wseq_(0)
+    , rwseq_(0)
+    , rrseq_(0)
+    , rseq_(0)
+{
+    static_assert((4096 % alignof(T)) == 0, "");
+
+    memset(pad0_, 0, sizeof(pad0_));
+    memset(pad1_, 0, sizeof(pad1_));
+    memset(pad2_, 0, sizeof(pad2_));
+    memset(pad3_, 0, sizeof(pad3_));
+}
+
+template<typename T, typename Sequence>
+bool snw::basic_pod_stream<T, Sequence>::try_write(const T& item) {
+    return write_n(&item, 1) == 1;
+}
+
+template<typename T, typename Sequence>
+size_t snw::basic_pod_stream<T, Sequence>::write_n(const T* items, size_t cnt) {
+    cnt = std::min(cnt, writable(cnt));
+    if (cnt == 0) {
+        return 0;
+    }
+
+    memcpy(deref(wwseq_), items, cnt * sizeof(T));
+    wwseq_ += cnt;
+    wseq_.store(wwseq_);
+    return cnt;
+}
+
+template<typename T, typename Sequence>
+bool snw::basic_pod_stream<T, Sequence>::try_read(T& item) {
+    return read_n(&item, 1) == 1;
+}
+
+template<typename T, typename Sequence>
+size_t snw::basic_pod_stream<T, Sequence>::read_n(T* items, size_t cnt) {
+    cnt = std::min(cnt, readable(cnt));
+    if (cnt == 0) {
+        return 0;
+    }
+
+    memcpy(items, deref(rrseq_), cnt * sizeof(T));
+    rrseq_ += cnt;
+    rseq_.store(rrseq_);
+    return cnt;
+}
+
+template<typename T, typename Sequence>
+template<typename ItemHandler>
+size_t snw::basic_pod_stream<T, Sequence>::read(ItemHandler&& handler, size_t max_cnt) {
+    // max_cnt==0 acts like max_cnt==infinity
+    size_t wanted = (max_cnt == 0) ? std::numeric_limits<size_t>::max() : max_cnt;
+    size_t cnt = std::min(readable(wanted), wanted);
+
+    const T* items = deref(rrseq_);
+    for (size_t i = 0; i < cnt; ++i) {
+        try {
+            handler(items[i]);
+        }
+        catch (...) {
+            // the item that threw counts as read
+            rrseq_ += i + 1;
+            rseq_.store(rrseq_);
+            throw;
+        }
+    }
+
+    rrseq_ += cnt;
+    rseq_.store(rrseq_);
+    return cnt;
+}
+
+// only refresh the cached sequences when they say there isn't enough
+template<typename T, typename Sequence>
+size_t snw::basic_pod_stream<T, Sequence>::writable(size_t wanted) {
+    size_t result = capacity_ - (wwseq_ - wrseq_);
+    if (result < wanted) {
+        wrseq_ = rseq_.load();
+        result = capacity_ - (wwseq_ - wrseq_);
+    }
+
+    return result;
+}
+
+template<typename T, typename Sequence>
+size_t snw::basic_pod_stream<T, Sequence>::readable(size_t wanted) {
+    size_t result = rwseq_ - rrseq_;
+    if (result < wanted) {
+        rwseq_ = wseq_.load();
+        result = rwseq_ - rrseq_;
+    }
+
+    return result;
+}
+
+template<typename T, typename Sequence>
+T* snw::basic_pod_stream<T, Sequence>::deref(size_t seq) {
+    size_t offset = (seq * sizeof(T)) & (buffer_.size() - 1);
+    return reinterpret_cast<T*>(&buffer_.data()[offset]);
+}
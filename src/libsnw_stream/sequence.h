@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace snw {
+
+// Sequence policies for the single producer streams (basic_byte_stream and
+// basic_pod_stream). The writer and the reader each own one sequence; the
+// owner publishes it with store() and the other side reads it with load().
+//
+// Only the publish/observe pairs need ordering: the store has to make the
+// data written before it visible, and the load has to happen before the
+// data is read. Acquire/release is enough for that, and on x86 both are
+// plain movs (a seq_cst store is an xchg).
+
+// single threaded (e.g. a thread talking to itself)
+class local_sequence {
+public:
+    explicit local_sequence(size_t value)
+        : value_(value)
+    {
+    }
+
+    size_t load() const {
+        return value_;
+    }
+
+    void store(size_t value) {
+        value_ = value;
+    }
+
+private:
+    size_t value_;
+};
+
+// one writer thread and one reader thread
+class atomic_sequence {
+public:
+    explicit atomic_sequence(size_t value)
+        : value_(value)
+    {
+    }
+
+    size_t load() const {
+        return value_.load(std::memory_order_acquire);
+    }
+
+    void store(size_t value) {
+        value_.store(value, std::memory_order_release);
+    }
+
+private:
+    std::atomic<size_t> value_;
+};
+
+}
@@ -0,0 +1,251 @@
+#include "shared_byte_stream.h"
+#include "align.h"
+#include "platform.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+#if defined(SNW_OS_UNIX)
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <fcntl.h>
+
+namespace {
+    static constexpr size_t page_size_ = 4096;
+    static constexpr size_t header_size_ = page_size_;
+    static constexpr uint64_t magic_ = 0x314d525453574e53; // "SNWSTRM1"
+    static constexpr uint64_t version_ = 1;
+
+    // the data size must be a power of 2 (for masking) and a multiple of the page size
+    size_t find_size(size_t min_size) {
+        size_t size = std::max(min_size, page_size_);
+        if (size > (static_cast<size_t>(1) << 62)) {
+            throw std::runtime_error("bad shared_byte_stream size");
+        }
+
+        size_t result = page_size_;
+        while (result < size) {
+            result *= 2;
+        }
+
+        return result;
+    }
+}
+
+snw::shared_byte_stream::shared_byte_stream()
+    : header_(nullptr)
+    , data_(nullptr)
+    , size_(0)
+    , wwseq_(0)
+    , wrseq_(0)
+    , wcseq_(0)
+    , publish_batch_(1)
+    , unpublished_(0)
+    , rwseq_(0)
+    , rrseq_(0)
+{
+    memset(pad0_, 0, sizeof(pad0_));
+    memset(pad1_, 0, sizeof(pad1_));
+    memset(pad2_, 0, sizeof(pad2_));
+}
+
+snw::shared_byte_stream snw::shared_byte_stream::create(const char* name, size_t min_size) {
+    static_assert(sizeof(header) <= header_size_, "");
+
+    size_t size = find_size(min_size);
+
+    int fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("failed create shared_byte_stream - shm_open");
+    }
+
+    shared_byte_stream stream;
+    try {
+        if (ftruncate(fd, header_size_ + size) < 0) {
+            throw std::runtime_error("failed create shared_byte_stream - ftruncate");
+        }
+
+        stream.map(fd, size);
+    }
+    catch (...) {
+        ::close(fd);
+        shm_unlink(name);
+        throw;
+    }
+
+    ::close(fd);
+    stream.name_ = name;
+
+    // the object starts out zeroed; publish the magic last so that
+    // attach can tell when the header is ready
+    header* hdr = stream.header_;
+    hdr->version = version_;
+    hdr->size = size;
+    hdr->magic.store(magic_, std::memory_order_release);
+
+    return stream;
+}
+
+snw::shared_byte_stream snw::shared_byte_stream::attach(const char* name) {
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        throw std::runtime_error("failed attach shared_byte_stream - shm_open");
+    }
+
+    shared_byte_stream stream;
+    try {
+        struct stat st;
+        if (fstat(fd, &st) < 0) {
+            throw std::runtime_error("failed attach shared_byte_stream - fstat");
+        }
+
+        size_t file_size = static_cast<size_t>(st.st_size);
+        if ((file_size <= header_size_) || !is_power_of_2(file_size - header_size_)) {
+            throw std::runtime_error("failed attach shared_byte_stream - bad size");
+        }
+
+        stream.map(fd, file_size - header_size_);
+    }
+    catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    ::close(fd);
+
+    header* hdr = stream.header_;
+    if ((hdr->magic.load(std::memory_order_acquire) != magic_) || (hdr->version != version_) || (hdr->size != stream.size_)) {
+        throw std::runtime_error("failed attach shared_byte_stream - bad header");
+    }
+
+    // pick up wherever the other side is
+    stream.wwseq_ = stream.wcseq_ = stream.rwseq_ = hdr->wseq.load(std::memory_order_acquire);
+    stream.wrseq_ = stream.rrseq_ = hdr->rseq.load(std::memory_order_acquire);
+
+    return stream;
+}
+
+snw::shared_byte_stream::shared_byte_stream(shared_byte_stream&& other)
+    : shared_byte_stream()
+{
+    *this = std::move(other);
+}
+
+snw::shared_byte_stream::~shared_byte_stream() {
+    close();
+}
+
+snw::shared_byte_stream& snw::shared_byte_stream::operator=(shared_byte_stream&& rhs) {
+    if (this != &rhs) {
+        close();
+
+        header_ = rhs.header_;
+        data_ = rhs.data_;
+        size_ = rhs.size_;
+        name_ = std::move(rhs.name_);
+        wwseq_ = rhs.wwseq_;
+        wrseq_ = rhs.wrseq_;
+        wcseq_ = rhs.wcseq_;
+        publish_batch_ = rhs.publish_batch_;
+        unpublished_ = rhs.unpublished_;
+        rwseq_ = rhs.rwseq_;
+        rrseq_ = rhs.rrseq_;
+
+        rhs.header_ = nullptr;
+        rhs.data_ = nullptr;
+        rhs.size_ = 0;
+        rhs.name_.clear();
+    }
+
+    return *this;
+}
+
+void snw::shared_byte_stream::close() {
+    if (*this) {
+        int rc;
+        rc = munmap(header_, header_size_ + (size_ * 2));
+        assert(rc >= 0);
+
+        if (!name_.empty()) {
+            shm_unlink(name_.c_str());
+            name_.clear();
+        }
+
+        header_ = nullptr;
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+// Map the header page followed by the data twice. The whole range is
+// reserved first so that the fixed mappings can't clobber anything else.
+void snw::shared_byte_stream::map(int fd, size_t size) {
+    size_t total_size = header_size_ + (size * 2);
+
+    void* addr = mmap(nullptr, total_size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("failed map shared_byte_stream - mmap reserve");
+    }
+
+    uint8_t* base = static_cast<uint8_t*>(addr);
+    void* lower_addr = base + header_size_;
+    void* upper_addr = base + header_size_ + size;
+
+    if ((mmap(base, header_size_ + size, PROT_READ|PROT_WRITE, MAP_FIXED|MAP_SHARED, fd, 0) == MAP_FAILED) ||
+        (mmap(upper_addr, size, PROT_READ|PROT_WRITE, MAP_FIXED|MAP_SHARED, fd, header_size_) == MAP_FAILED)) {
+        int rc;
+        rc = munmap(base, total_size);
+        assert(rc >= 0);
+        throw std::runtime_error("failed map shared_byte_stream - mmap");
+    }
+
+    header_ = reinterpret_cast<header*>(base);
+    data_ = static_cast<uint8_t*>(lower_addr);
+    size_ = size;
+}
+
+#else
+
+snw::shared_byte_stream::shared_byte_stream()
+    : header_(nullptr)
+    , data_(nullptr)
+    , size_(0)
+    , wwseq_(0)
+    , wrseq_(0)
+    , wcseq_(0)
+    , publish_batch_(1)
+    , unpublished_(0)
+    , rwseq_(0)
+    , rrseq_(0)
+{
+}
+
+snw::shared_byte_stream snw::shared_byte_stream::create(const char* name, size_t min_size) {
+    throw std::runtime_error("not implemented");
+}
+
+snw::shared_byte_stream snw::shared_byte_stream::attach(const char* name) {
+    throw std::runtime_error("not implemented");
+}
+
+snw::shared_byte_stream::shared_byte_stream(shared_byte_stream&& other)
+    : shared_byte_stream()
+{
+    throw std::runtime_error("not implemented");
+}
+
+snw::shared_byte_stream::~shared_byte_stream() {
+}
+
+snw::shared_byte_stream& snw::shared_byte_stream::operator=(shared_byte_stream&& rhs) {
+    throw std::runtime_error("not implemented");
+}
+
+void snw::shared_byte_stream::close() {
+}
+
+#endif
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace snw {
+
+// A byte stream that lives entirely in a named shared memory object, so
+// that it can be shared between processes. The object holds a header page
+// (with the read and write sequences on separate cache lines) followed by
+// the data, which is mapped twice back to back like stream_buffer.
+//
+// One process creates the stream and the other attaches to it by name.
+// Either side can be the writer, but there must be exactly one writer and
+// one reader. The creator removes the name when it closes the stream; a
+// process that is already attached keeps its mapping.
+//
+// The interface is the same as basic_byte_stream (including the publish
+// batch), with the writer's and reader's cached sequences kept in each
+// process. It can be the Stream of a basic_message_stream (see its Stream
+// constructor), so that messages are written straight into the shared
+// memory by one process and read in place by the other.
+class shared_byte_stream {
+public:
+    // throws if the name already exists
+    static shared_byte_stream create(const char* name, size_t min_size);
+
+    // throws if the name doesn't exist (or isn't a shared_byte_stream)
+    static shared_byte_stream attach(const char* name);
+
+    shared_byte_stream(shared_byte_stream&& other);
+    shared_byte_stream(const shared_byte_stream&) = delete;
+    ~shared_byte_stream();
+
+    shared_byte_stream& operator=(shared_byte_stream&& rhs);
+    shared_byte_stream& operator=(const shared_byte_stream&) = delete;
+
+    explicit operator bool() const {
+        return header_ != nullptr;
+    }
+
+    void close();
+
+    size_t size() const {
+        return size_;
+    }
+
+public:
+    size_t writable() const {
+        return size_ - (wwseq_ - wrseq_);
+    }
+
+    // the biggest write that can ever succeed
+    size_t max_write_size() const {
+        return size_;
+    }
+
+    void write_begin() {
+        wrseq_ = header_->rseq.load(std::memory_order_acquire);
+    }
+
+    bool write_commit() {
+        wcseq_ = wwseq_;
+        if (++unpublished_ >= publish_batch_) {
+            return flush();
+        }
+
+        return false;
+    }
+
+    void write_rollback() {
+        wwseq_ = wcseq_;
+    }
+
+    void set_publish_batch(size_t publish_batch) {
+        publish_batch_ = (publish_batch == 0) ? 1 : publish_batch;
+        if (unpublished_ >= publish_batch_) {
+            flush();
+        }
+    }
+
+    bool flush() {
+        if (unpublished_ == 0) {
+            return false;
+        }
+
+        unpublished_ = 0;
+        header_->wseq.store(wcseq_, std::memory_order_release);
+        return true;
+    }
+
+    template<size_t len>
+    void* write() {
+        return write(len);
+    }
+
+    void* write(size_t len) {
+        if (writable() < len) {
+            flush(); // see basic_byte_stream::publish_full
+            return nullptr;
+        }
+
+        void* buf = deref(wwseq_);
+        wwseq_ += len;
+        return buf;
+    }
+
+public:
+    size_t readable() const {
+        return rwseq_ - rrseq_;
+    }
+
+    void read_begin() {
+        rwseq_ = header_->wseq.load(std::memory_order_acquire);
+    }
+
+    void read_commit() {
+        header_->rseq.store(rrseq_, std::memory_order_release);
+    }
+
+    void read_rollback() {
+        rrseq_ = header_->rseq.load(std::memory_order_relaxed);
+    }
+
+    template<size_t len>
+    void* read() {
+        return read(len);
+    }
+
+    void* read(size_t len) {
+        if (readable() < len) {
+            return nullptr;
+        }
+
+        void* buf = deref(rrseq_);
+        rrseq_ += len;
+        return buf;
+    }
+
+private:
+    struct header {
+        std::atomic<uint64_t> magic;
+        uint64_t              version;
+        uint64_t              size;
+        uint8_t               pad0[64 - (3 * sizeof(uint64_t))];
+        std::atomic<size_t>   wseq;
+        uint8_t               pad1[64 - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t>   rseq;
+        uint8_t               pad2[64 - sizeof(std::atomic<size_t>)];
+    };
+
+    shared_byte_stream();
+
+    void map(int fd, size_t size);
+
+    void* deref(size_t seq) {
+        return &data_[seq & (size_ - 1)];
+    }
+
+private:
+    header*     header_;
+    uint8_t*    data_;
+    size_t      size_;
+    std::string name_; // empty unless we created it
+
+    uint8_t     pad0_[64];
+    size_t      wwseq_; // writer's cached wseq
+    size_t      wrseq_; // writer's cached rseq
+    size_t      wcseq_; // writer's committed wseq (published or not)
+    size_t      publish_batch_;
+    size_t      unpublished_; // commits since the last publish
+
+    uint8_t     pad1_[64];
+    size_t      rwseq_; // reader's cached wseq
+    size_t      rrseq_; // reader's cached rseq
+
+    uint8_t     pad2_[64];
+};
+
+}
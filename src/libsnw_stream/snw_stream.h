@@ -1,5 +1,16 @@
 #pragma once
 
 #include "stream_buffer.h"
+#include "stream_buffer_pool.h"
+#include "sequence.h"
 #include "byte_stream.h"
+#include "elastic_byte_stream.h"
+#include "shared_byte_stream.h"
+#include "wait_strategy.h"
 #include "message_stream.h"
+#include "mpsc_message_stream.h"
+#include "broadcast_message_stream.h"
+#include "pod_stream.h"
+#include "conflating_stream.h"
+#include "journal.h"
+#include "journal_replayer.h"
@@ -1,8 +1,11 @@
 #include "stream_buffer.h"
+#include "stream_buffer_pool.h"
 #include "align.h"
 #include "platform.h"
 #include <stdexcept>
 #include <algorithm>
+#include <limits>
+#include <atomic>
 #include <cstdio>
 #include <cstring>
 #include <cassert>
@@ -16,136 +19,216 @@
 #include <sys/syscall.h>
 #include <fcntl.h>
 
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB 0x0004U
+#endif
+
 namespace {
     static constexpr size_t page_size_ = 4096;
+    static constexpr size_t huge_page_size_ = 2 * 1024 * 1024;
 
     // find a size that satisfies the following constraints:
     //    1. size > 0
     //    2. size >= min_size
-    //    3. (size % page_size_) == 0
+    //    3. (size % granularity) == 0
     //    4. is_power_of_2(size)
     //
-    size_t find_size(size_t min_size) {
-        if (min_size == std::numeric_limits<size_t>::max()) {
-            // align_up would cause an overflow
+    size_t find_size(size_t min_size, size_t granularity) {
+        if (min_size > (std::numeric_limits<size_t>::max() / 4)) {
+            // align_up would cause an overflow (and we couldn't map it twice anyway)
             throw std::runtime_error("bad stream_buffer size");
         }
 
         size_t size = std::max(min_size, static_cast<size_t>(1));
-        size = snw::align_up(size, page_size_);
+        size = snw::align_up(size, granularity);
         while (!snw::is_power_of_2(size)) {
-            size += page_size_;
+            size += granularity;
         }
 
         assert(size > 0);
         assert(size >= min_size);
-        assert((size % page_size_) == 0);
+        assert((size % granularity) == 0);
         assert(snw::is_power_of_2(size));
 
         return size;
     }
+
+    // Create an anonymous file to back the buffer. Returns -1 on failure.
+    int create_fd(bool huge_pages) {
+#if defined(SNW_OS_LINUX) && defined(SYS_memfd_create)
+        unsigned int flags = MFD_CLOEXEC | (huge_pages ? MFD_HUGETLB : 0);
+        int fd = static_cast<int>(syscall(SYS_memfd_create, "stream_buffer", flags));
+        if ((fd >= 0) || huge_pages) {
+            return fd;
+        }
+#endif
+
+        // hugetlb pages are only available through memfd
+        if (huge_pages) {
+            return -1;
+        }
+
+        // fall back to a shm object with a name that is unique within the
+        // process, and unlink it right away (so that it doesn't stick around
+        // in /dev/shm in case we crash...)
+        static std::atomic<unsigned int> counter(0);
+
+        char name[64];
+        int pid = static_cast<int>(snw::get_current_process_id());
+        if (snprintf(name, sizeof(name), "/stream_buffer_%d_%u.shm", pid, counter++) < 0) {
+            return -1;
+        }
+
+        int shm_fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0600);
+        if (shm_fd < 0) {
+            return -1;
+        }
+
+        shm_unlink(name);
+        return shm_fd;
+    }
 }
 
-snw::stream_buffer::stream_buffer(size_t min_size = 0)
-    : size_(0)
-    , data_(static_cast<uint8_t*>(MAP_FAILED))
+snw::stream_buffer::stream_buffer(size_t min_size, prefault_mode prefault, bool huge_pages)
+    : data_(static_cast<uint8_t*>(MAP_FAILED))
+    , size_(0)
     , fd_(-1)
+    , huge_pages_(false)
+    , locked_(false)
 {
-    size_ = find_size(min_size);
+    if (huge_pages) {
+        if (reuse(find_size(min_size, huge_page_size_), prefault, true) || map(min_size, prefault, true)) {
+            return;
+        }
+    }
 
-    // TODO: Use scope guards or labels for error handling
+    if (reuse(find_size(min_size, page_size_), prefault, false)) {
+        return;
+    }
 
-    // create a temporary name for the shm
-    char name[64];
-    int pid = static_cast<int>(get_current_process_id());
-    int tid = static_cast<int>(get_current_thread_id());
-    if (snprintf(name, sizeof(name), "stream_buffer_%d_%d.shm", pid, tid) < 0) {
-        throw std::runtime_error("failed create stream_buffer - snprintf");
+    if (!map(min_size, prefault, false)) {
+        throw std::runtime_error("failed create stream_buffer");
     }
+}
+
+bool snw::stream_buffer::reuse(size_t size, prefault_mode prefault, bool huge_pages) {
+    bool locked = (prefault == prefault_mode::lock);
 
-    // create the shm
-    fd_ = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0644);
-    if (fd_ < 0) {
-        throw std::runtime_error("failed create stream_buffer - shm_open");
+    stream_buffer_mapping mapping;
+    if (!stream_buffer_pool::instance().pop(size, huge_pages, locked, mapping)) {
+        return false;
     }
 
-    // unlink the shm (so that it doesn't stick around in /dev/shm in case we crash...)
-    if (shm_unlink(name) < 0) {
-        if (errno == ENOENT) {
-            // removed, but not by us
-        }
-        else {
-            int rc;
-            rc = ::close(fd_);
-            assert(rc >= 0);
-            throw std::runtime_error("failed create stream_buffer - shm_unlink");
+    data_ = mapping.data;
+    size_ = mapping.size;
+    fd_ = mapping.fd;
+    huge_pages_ = mapping.huge_pages;
+    locked_ = mapping.locked;
+    return true;
+}
+
+// Map the buffer twice into a range that is reserved up front (so that the
+// fixed mappings can't clobber anything). Failures with huge pages return
+// false so that the caller can fall back to regular pages; other failures
+// throw.
+bool snw::stream_buffer::map(size_t min_size, prefault_mode prefault, bool huge_pages) {
+    size_t granularity = huge_pages ? huge_page_size_ : page_size_;
+    size_t size = find_size(min_size, granularity);
+
+    int fd = create_fd(huge_pages);
+    if (fd < 0) {
+        if (huge_pages) {
+            return false;
         }
+        throw std::runtime_error("failed create stream_buffer - memfd_create/shm_open");
     }
 
-    // resize the shm
-    if (ftruncate(fd_, size_) < 0) {
+    if (ftruncate(fd, size) < 0) {
         int rc;
-        rc = ::close(fd_);
+        rc = ::close(fd);
         assert(rc >= 0);
+        if (huge_pages) {
+            return false;
+        }
         throw std::runtime_error("failed create stream_buffer - ftruncate");
     }
 
-    // allocate enough virtual memory to fit the shm object twice (for the upper/lower mapping)
-    void* lower_addr = mmap(nullptr, size_ * 2, PROT_READ|PROT_WRITE, MAP_SHARED, fd_, 0);
-    if (lower_addr == MAP_FAILED) {
+    // over-reserve so that huge page mappings can be aligned
+    size_t reserve_size = (size * 2) + (huge_pages ? huge_page_size_ : 0);
+    void* reserve_addr = mmap(nullptr, reserve_size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (reserve_addr == MAP_FAILED) {
         int rc;
-        rc = ::close(fd_);
+        rc = ::close(fd);
         assert(rc >= 0);
-        throw std::runtime_error("failed create stream_buffer - mmap 1");
+        throw std::runtime_error("failed create stream_buffer - mmap reserve");
+    }
+
+    uint8_t* reserve_first = static_cast<uint8_t*>(reserve_addr);
+    uint8_t* reserve_last = reserve_first + reserve_size;
+    uint8_t* first = align_up(reserve_first, granularity);
+    uint8_t* last = first + (size * 2);
+
+    int flags = MAP_FIXED|MAP_SHARED;
+    if (prefault != prefault_mode::none) {
+        flags |= MAP_POPULATE;
     }
 
-#if 0
-    // this is needed if the os doesn't like us overwriting an existing mapping, but it
-    // introduces a race
-    void* new_lower_addr=  mremap(lower_addr, size_ * 2, size_, MREMAP_MAYMOVE, lower_addr);
-    if (new_lower_addr == MAP_FAILED) {
+    if ((mmap(first, size, PROT_READ|PROT_WRITE, flags, fd, 0) == MAP_FAILED) ||
+        (mmap(first + size, size, PROT_READ|PROT_WRITE, flags, fd, 0) == MAP_FAILED)) {
         int rc;
-        rc = ::close(fd_);
+        rc = munmap(reserve_first, reserve_size);
         assert(rc >= 0);
-        rc = munmap(lower_addr, size_ * 2);
+        rc = ::close(fd);
         assert(rc >= 0);
-        throw std::runtime_error("failed create stream_buffer - mremap");
+        if (huge_pages) {
+            return false;
+        }
+        throw std::runtime_error("failed create stream_buffer - mmap");
     }
-    else if (new_lower_addr != lower_addr) {
-        int rc;
-        rc = ::close(fd_);
+
+    // give back the slop on either side
+    int rc;
+    if (reserve_first < first) {
+        rc = munmap(reserve_first, first - reserve_first);
         assert(rc >= 0);
-        rc = munmap(new_lower_addr, size_);
+    }
+    if (last < reserve_last) {
+        rc = munmap(last, reserve_last - last);
         assert(rc >= 0);
-        throw std::runtime_error("failed create stream_buffer - mremap (moved)");
     }
-#endif
-
-    data_ = reinterpret_cast<uint8_t*>(lower_addr);
 
-    // do the upper mapping
-    void* upper_addr = mmap(data_+ size_, size_, PROT_READ|PROT_WRITE, MAP_FIXED|MAP_SHARED, fd_, 0);
-    if (upper_addr == MAP_FAILED) {
-        int rc;
-        rc = ::close(fd_);
+    if ((prefault == prefault_mode::lock) && (mlock(first, size * 2) < 0)) {
+        rc = munmap(first, size * 2);
         assert(rc >= 0);
-        rc = munmap(lower_addr, size_);
+        rc = ::close(fd);
         assert(rc >= 0);
-        throw std::runtime_error("failed create stream_buffer - mmap 2");
+        throw std::runtime_error("failed create stream_buffer - mlock");
     }
 
-    // fault pages and sanity check that we don't get a SIGSEGV
-    memset(data_, 0, size_ * 2);
+    data_ = first;
+    size_ = size;
+    fd_ = fd;
+    huge_pages_ = huge_pages;
+    locked_ = (prefault == prefault_mode::lock);
+    return true;
 }
 
 snw::stream_buffer::stream_buffer(stream_buffer&& other)
-    : size_(other.size_)
-    , data_(other.data_)
+    : data_(other.data_)
+    , size_(other.size_)
     , fd_(other.fd_)
+    , huge_pages_(other.huge_pages_)
+    , locked_(other.locked_)
 {
-    other.size_ = 0;
     other.data_ = static_cast<uint8_t*>(MAP_FAILED);
+    other.size_ = 0;
     other.fd_ = -1;
+    other.huge_pages_ = false;
+    other.locked_ = false;
 }
 
 snw::stream_buffer::~stream_buffer() {
@@ -156,13 +239,17 @@ snw::stream_buffer& snw::stream_buffer::operator=(stream_buffer&& rhs) {
     if (this != &rhs) {
         close();
 
-        size_ = rhs.size_;
         data_ = rhs.data_;
+        size_ = rhs.size_;
         fd_ = rhs.fd_;
+        huge_pages_ = rhs.huge_pages_;
+        locked_ = rhs.locked_;
 
-        rhs.size_ = 0;
         rhs.data_ = static_cast<uint8_t*>(MAP_FAILED);
+        rhs.size_ = 0;
         rhs.fd_ = -1;
+        rhs.huge_pages_ = false;
+        rhs.locked_ = false;
     }
 
     return *this;
@@ -174,39 +261,48 @@ snw::stream_buffer::operator bool() const {
 
 void snw::stream_buffer::close() {
     if (*this) {
-        int rc;
+        stream_buffer_mapping mapping;
+        mapping.data = data_;
+        mapping.size = size_;
+        mapping.fd = fd_;
+        mapping.huge_pages = huge_pages_;
+        mapping.locked = locked_;
+        stream_buffer_pool::instance().push(mapping);
 
-        void* lower_addr = data_;
-        rc = munmap(lower_addr, size_);
-        assert(rc >= 0);
-
-        void* upper_addr = data_ + size_;
-        rc = munmap(upper_addr, size_);
-        assert(rc >= 0);
-
-        rc = ::close(fd_);
-        assert(rc >= 0);
-
-        size_ = 0;
         data_ = static_cast<uint8_t*>(MAP_FAILED);
+        size_ = 0;
         fd_ = -1;
+        huge_pages_ = false;
+        locked_ = false;
     }
 }
 
 #else
 
-snw::stream_buffer::stream_buffer(size_t min_size)
-    : size_(0)
-    , data_(NULL)
+snw::stream_buffer::stream_buffer(size_t min_size, prefault_mode prefault, bool huge_pages)
+    : data_(NULL)
+    , size_(0)
     , fd_(-1)
+    , huge_pages_(false)
+    , locked_(false)
 {
     throw std::runtime_error("not implemented");
 }
 
+bool snw::stream_buffer::reuse(size_t size, prefault_mode prefault, bool huge_pages) {
+    throw std::runtime_error("not implemented");
+}
+
+bool snw::stream_buffer::map(size_t min_size, prefault_mode prefault, bool huge_pages) {
+    throw std::runtime_error("not implemented");
+}
+
 snw::stream_buffer::stream_buffer(stream_buffer&& other)
-    : size_(other.size_)
-    , data_(other.data_)
+    : data_(other.data_)
+    , size_(other.size_)
     , fd_(other.fd_)
+    , huge_pages_(other.huge_pages_)
+    , locked_(other.locked_)
 {
     throw std::runtime_error("not implemented");
 }
@@ -5,9 +5,25 @@
 
 namespace snw {
 
+enum class prefault_mode {
+    none,     // pages are faulted in as they're first touched
+    populate, // fault everything in up front (MAP_POPULATE)
+    lock,     // fault everything in and lock it in memory (mlock)
+};
+
+// A ring buffer of at least min_size bytes that is mapped twice back to
+// back, so that reads and writes that wrap around the end are contiguous.
+//
+// The memory comes from an anonymous memfd (or an unlinked shm object where
+// memfd isn't available). If huge_pages is set it's backed by hugetlb pages
+// when possible (the size is then a multiple of the huge page size), falling
+// back to regular pages if none are available.
+//
+// Closed buffers go back to the stream_buffer_pool, and new buffers are
+// taken from it when there's one of the right size.
 class stream_buffer {
 public:
-    stream_buffer(size_t min_size);
+    stream_buffer(size_t min_size, prefault_mode prefault = prefault_mode::none, bool huge_pages = false);
     stream_buffer(stream_buffer&& other);
     stream_buffer(const stream_buffer&) = delete;
     ~stream_buffer();
@@ -30,10 +46,21 @@ public:
         return data_;
     }
 
+    // true if the buffer is backed by huge pages
+    bool huge_pages() const {
+        return huge_pages_;
+    }
+
+private:
+    bool reuse(size_t size, prefault_mode prefault, bool huge_pages);
+    bool map(size_t min_size, prefault_mode prefault, bool huge_pages);
+
 private:
     uint8_t* data_;
     size_t   size_;
     int      fd_;
+    bool     huge_pages_;
+    bool     locked_;
 };
 
 }
@@ -0,0 +1,129 @@
+#include "stream_buffer_pool.h"
+#include "platform.h"
+#include "bits.h"
+#include "align.h"
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+
+#if defined(SNW_OS_UNIX)
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+constexpr size_t snw::stream_buffer_pool::default_capacity;
+
+// never destroyed, since stream_buffers with static storage duration may
+// be closed after it would have been
+snw::stream_buffer_pool& snw::stream_buffer_pool::instance() {
+    static stream_buffer_pool* pool = new stream_buffer_pool();
+    return *pool;
+}
+
+snw::stream_buffer_pool::stream_buffer_pool()
+    : capacity_(default_capacity)
+    , size_(0)
+    , hits_(0)
+{
+}
+
+size_t snw::stream_buffer_pool::capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+}
+
+void snw::stream_buffer_pool::set_capacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    trim(capacity);
+}
+
+size_t snw::stream_buffer_pool::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+size_t snw::stream_buffer_pool::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+void snw::stream_buffer_pool::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    trim(0);
+}
+
+void snw::stream_buffer_pool::push(const stream_buffer_mapping& mapping) {
+    assert(is_power_of_2(mapping.size));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if ((size_ + mapping.size) <= capacity_) {
+            buckets_[count_trailing_zeros(static_cast<uint64_t>(mapping.size))].push_back(mapping);
+            size_ += mapping.size;
+            return;
+        }
+    }
+
+    release(mapping);
+}
+
+bool snw::stream_buffer_pool::pop(size_t size, bool huge_pages, bool locked, stream_buffer_mapping& mapping) {
+    assert(is_power_of_2(size));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // most recently pushed first, since it's the most likely to be cached
+        std::vector<stream_buffer_mapping>& bucket = buckets_[count_trailing_zeros(static_cast<uint64_t>(size))];
+        size_t i = bucket.size();
+        while ((i > 0) && ((bucket[i - 1].huge_pages != huge_pages) || (bucket[i - 1].locked != locked))) {
+            --i;
+        }
+
+        if (i == 0) {
+            return false;
+        }
+
+        mapping = bucket[i - 1];
+        bucket.erase(bucket.begin() + (i - 1));
+        size_ -= size;
+        ++hits_;
+    }
+
+    // the upper half is the same memory
+    memset(mapping.data, 0, mapping.size);
+    return true;
+}
+
+void snw::stream_buffer_pool::trim(size_t capacity) {
+    for (int i = bucket_count - 1; (i >= 0) && (size_ > capacity); --i) {
+        std::vector<stream_buffer_mapping>& bucket = buckets_[i];
+        while (!bucket.empty() && (size_ > capacity)) {
+            release(bucket.front());
+            size_ -= bucket.front().size;
+            bucket.erase(bucket.begin());
+        }
+    }
+}
+
+#if defined(SNW_OS_UNIX)
+
+void snw::stream_buffer_pool::release(const stream_buffer_mapping& mapping) {
+    int rc;
+
+    // both halves (this also undoes mlock)
+    rc = munmap(mapping.data, mapping.size * 2);
+    assert(rc >= 0);
+
+    rc = ::close(mapping.fd);
+    assert(rc >= 0);
+}
+
+#else
+
+void snw::stream_buffer_pool::release(const stream_buffer_mapping& mapping) {
+    throw std::runtime_error("not implemented");
+}
+
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace snw {
+
+// a mirrored mapping made by stream_buffer
+struct stream_buffer_mapping {
+    uint8_t* data;
+    size_t   size;
+    int      fd;
+    bool     huge_pages;
+    bool     locked;
+};
+
+// A process-wide cache of the mappings of closed stream_buffers, bucketed
+// by size, so that creating a stream_buffer of a recently used size doesn't
+// need any syscalls. Reused mappings are zeroed so that they look fresh.
+//
+// The cache holds at most capacity() bytes (counting each mapping once);
+// setting it to 0 turns pooling off.
+class stream_buffer_pool {
+public:
+    static constexpr size_t default_capacity = 64 * 1024 * 1024;
+
+    static stream_buffer_pool& instance();
+
+    stream_buffer_pool(stream_buffer_pool&&) = delete;
+    stream_buffer_pool(const stream_buffer_pool&) = delete;
+
+    stream_buffer_pool& operator=(stream_buffer_pool&&) = delete;
+    stream_buffer_pool& operator=(const stream_buffer_pool&) = delete;
+
+    size_t capacity() const;
+    void set_capacity(size_t capacity);
+
+    // number of bytes held
+    size_t size() const;
+
+    // number of mappings that have been reused
+    size_t hits() const;
+
+    // unmap everything held
+    void clear();
+
+    // Keep a mapping (or unmap it if the pool is full).
+    void push(const stream_buffer_mapping& mapping);
+
+    // Take a zeroed mapping matching the arguments, or return false.
+    bool pop(size_t size, bool huge_pages, bool locked, stream_buffer_mapping& mapping);
+
+    // unmap a mapping
+    static void release(const stream_buffer_mapping& mapping);
+
+private:
+    static constexpr int bucket_count = 64;
+
+    stream_buffer_pool();
+    ~stream_buffer_pool() = delete;
+
+    void trim(size_t capacity);
+
+private:
+    mutable std::mutex                 mutex_;
+    size_t                             capacity_;
+    size_t                             size_;
+    size_t                             hits_;
+    std::vector<stream_buffer_mapping> buckets_[bucket_count]; // by log2(size)
+};
+
+}
@@ -0,0 +1,31 @@
+#include "wait_strategy.h"
+#include "platform.h"
+#include <climits>
+
+#if defined(SNW_OS_LINUX)
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// returns when the epoch changes (or spuriously)
+void snw::futex_wait::sleep(uint32_t epoch) {
+    static_assert(sizeof(epoch_) == sizeof(uint32_t), "");
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, epoch, nullptr, nullptr, 0);
+}
+
+void snw::futex_wait::wake() {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+#else
+
+// no futexes, so fall back to yielding
+void snw::futex_wait::sleep(uint32_t epoch) {
+    std::this_thread::yield();
+}
+
+void snw::futex_wait::wake() {
+}
+
+#endif
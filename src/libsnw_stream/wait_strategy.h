@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+#include "types.h"
+
+namespace snw {
+
+// Wait strategies decide what a reader does while a stream is empty.
+//
+//   wait(ready) returns once ready() is true
+//   notify()    is called by the writer after every commit that publishes
+//               (and after a write that doesn't fit, which publishes too)
+//
+// A strategy is shared by the reader and the writer of one stream.
+
+// Burn the core for the lowest latency.
+class spin_wait {
+public:
+    template<typename Ready>
+    void wait(Ready&& ready) {
+        while (!ready()) {
+            _mm_pause();
+        }
+    }
+
+    void notify() {
+    }
+};
+
+// Spin for a while, then give up the time slice between checks.
+class yield_wait {
+public:
+    yield_wait(int spin_count = 100)
+        : spin_count_(spin_count)
+    {
+    }
+
+    template<typename Ready>
+    void wait(Ready&& ready) {
+        for (int i = 0; !ready(); ++i) {
+            if (i < spin_count_) {
+                _mm_pause();
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void notify() {
+    }
+
+private:
+    int spin_count_;
+};
+
+// Spin for a while, then sleep in the kernel until the writer wakes us.
+// The writer only makes a syscall when the reader has said it's asleep.
+//
+// The sequences are published with release stores and read with acquire
+// loads (see sequence.h), which on their own would let the writer's check of
+// waiting_ pass its publish, and the reader's check of the sequence pass its
+// store to waiting_ (so both miss each other and the reader sleeps through
+// the wakeup). A seq_cst fence on each side orders them, so notify is a
+// full fence (an mfence on x86, tens of cycles) and a load when nobody is
+// waiting. With a publish batch it's only paid once per published batch.
+class futex_wait {
+public:
+    futex_wait(int spin_count = 100)
+        : spin_count_(spin_count)
+        , waiting_(0)
+        , epoch_(0)
+    {
+    }
+
+    futex_wait(const futex_wait&) = delete;
+    futex_wait& operator=(const futex_wait&) = delete;
+
+    template<typename Ready>
+    void wait(Ready&& ready) {
+        for (int i = 0; i < spin_count_; ++i) {
+            if (ready()) {
+                return;
+            }
+            _mm_pause();
+        }
+
+        while (true) {
+            uint32_t epoch = epoch_.load();
+            waiting_.store(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ready()) {
+                break;
+            }
+
+            sleep(epoch);
+        }
+
+        waiting_.store(0, std::memory_order_relaxed);
+    }
+
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_.load()) {
+            epoch_.fetch_add(1);
+            wake();
+        }
+    }
+
+private:
+    void sleep(uint32_t epoch);
+    void wake();
+
+private:
+    int                   spin_count_;
+    std::atomic<uint32_t> waiting_;
+    std::atomic<uint32_t> epoch_; // the futex word
+};
+
+}
@@ -27,6 +27,9 @@ public:
     // next = prev = this
     void self_link();
 
+    // move the linked range [first, last] in front of this
+    void splice(intrusive_list_node* first, intrusive_list_node* last);
+
     intrusive_list_node* next();
     const intrusive_list_node* next() const;
     intrusive_list_node* prev();
@@ -130,6 +133,9 @@ public:
     void pop_back();
     void clear();
 
+    // move every element of other in front of pos in O(1)
+    void splice(const_iterator pos, intrusive_list& other);
+
 private:
     intrusive_list_node root_;
 };
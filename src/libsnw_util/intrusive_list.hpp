@@ -123,6 +123,22 @@ inline void intrusive_list_node::self_link()
     prev_ = this;
 }
 
+inline void intrusive_list_node::splice(intrusive_list_node* first, intrusive_list_node* last)
+{
+    assert(first->is_linked() && last->is_linked());
+
+    // cut the range out of its current list
+    first->prev_->next_ = last->next_;
+    last->next_->prev_ = first->prev_;
+
+    // and stitch it in front of this
+    auto prev = prev_;
+    prev->next_ = first;
+    first->prev_ = prev;
+    last->next_ = this;
+    prev_ = last;
+}
+
 inline intrusive_list_node* intrusive_list_node::next()
 {
     return next_;
@@ -416,3 +432,14 @@ void intrusive_list<T, member_node>::clear()
         it = erase(it);
     }
 }
+
+template <typename T, intrusive_list_node T::*member_node>
+void intrusive_list<T, member_node>::splice(const_iterator pos, intrusive_list& other)
+{
+    if(&other == this || other.empty()) {
+        return;
+    }
+
+    auto node = const_cast<intrusive_list_node*>(pos.node());
+    node->splice(other.root_.next(), other.root_.prev());
+}
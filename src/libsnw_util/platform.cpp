@@ -1,5 +1,7 @@
 #include "platform.h"
 
+#include <cstdio>
+
 #if defined(SNW_OS_UNIX)
 #include <sys/types.h>
 #include <sys/syscall.h>
@@ -27,3 +29,47 @@ snw::thread_id snw::get_current_thread_id() {
 #error "not implemented"
 #endif
 }
+
+int snw::get_numa_node_count() {
+#if defined(SNW_OS_LINUX)
+    static const int node_count = []() {
+        // formatted like "0" or "0-3" or "0,2-3"
+        FILE* file = fopen("/sys/devices/system/node/online", "r");
+        if (!file) {
+            return 1;
+        }
+
+        int max_node = 0;
+        int node;
+        while (fscanf(file, "%d", &node) == 1) {
+            if (node > max_node) {
+                max_node = node;
+            }
+            if (fgetc(file) == EOF) {
+                break;
+            }
+        }
+        fclose(file);
+
+        return max_node + 1;
+    }();
+
+    return node_count;
+#else
+    return 1;
+#endif
+}
+
+snw::numa_node_id snw::get_current_numa_node() {
+#if defined(SNW_OS_LINUX) && defined(SYS_getcpu)
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) < 0) {
+        return 0;
+    }
+
+    return static_cast<numa_node_id>(node);
+#else
+    return 0;
+#endif
+}
@@ -13,8 +13,15 @@ namespace snw {
 
 using process_id = int;
 using thread_id = int;
+using numa_node_id = int;
 
 process_id get_current_process_id();
 thread_id get_current_thread_id();
 
+// number of numa nodes (1 if numa isn't supported)
+int get_numa_node_count();
+
+// the node of the cpu that the calling thread is running on (it may migrate)
+numa_node_id get_current_numa_node();
+
 }
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <type_traits>
+#include "types.h"
+
+namespace snw {
+
+// A non-owning view of a contiguous sequence of T.
+template<typename T>
+class span {
+public:
+    using value_type = typename std::remove_cv<T>::type;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+public:
+    span()
+        : data_(nullptr)
+        , size_(0)
+    {
+    }
+
+    span(T* data, size_t size)
+        : data_(data)
+        , size_(size)
+    {
+    }
+
+    span(T* first, T* last)
+        : data_(first)
+        , size_(static_cast<size_t>(last - first))
+    {
+    }
+
+    // span<T> converts to span<const T>
+    template<typename U, typename = typename std::enable_if<std::is_convertible<U(*)[], T(*)[]>::value>::type>
+    span(const span<U>& other)
+        : data_(other.data())
+        , size_(other.size())
+    {
+    }
+
+    T* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    iterator begin() const {
+        return data_;
+    }
+
+    iterator end() const {
+        return data_ + size_;
+    }
+
+    T& operator[](size_t index) const {
+        assert(index < size_);
+        return data_[index];
+    }
+
+    span subspan(size_t offset, size_t count) const {
+        assert(offset <= size_);
+        assert(count <= (size_ - offset));
+        return span(data_ + offset, count);
+    }
+
+    // true unless default constructed (a reserved span may be empty but still valid)
+    explicit operator bool() const {
+        return data_ != nullptr;
+    }
+
+private:
+    T*     data_;
+    size_t size_;
+};
+
+}
@@ -57,6 +57,11 @@ namespace snw {
             return is_quiescent();
         }
 
+        // the mutex's version when the lock was taken
+        int64_t version() const {
+            return version_;
+        }
+
     private:
         weak_lock(weak_lock&&) = delete;
         weak_lock(const weak_lock&) = delete;
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include "bench.h"
+#include "page_allocator.h"
+#include "concurrent_page_stack.h"
+
+namespace {
+
+constexpr size_t node_count = 64;
+constexpr size_t iteration_count = 1000000;
+
+// the baseline that concurrent_page_stack is meant to replace
+class locked_page_stack {
+public:
+    void push_node(snw::page* node) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        nodes_.attach_node(node);
+    }
+
+    snw::page* pop_node() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return nodes_.detach_node();
+    }
+
+private:
+    std::mutex      mutex_;
+    snw::page_stack nodes_;
+};
+
+// every thread pops a node and pushes it straight back
+template<typename Stack>
+double run(Stack& stack, size_t thread_count) {
+    std::atomic<size_t> ready(0);
+    std::atomic<bool> go(false);
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&]() {
+            ++ready;
+            while (!go) {
+            }
+
+            for (size_t j = 0; j < iteration_count; ++j) {
+                if (snw::page* node = stack.pop_node()) {
+                    stack.push_node(node);
+                }
+            }
+        });
+    }
+
+    while (ready != thread_count) {
+    }
+
+    snw::stopwatch stopwatch;
+    go = true;
+    for (std::thread& thread: threads) {
+        thread.join();
+    }
+
+    return stopwatch.elapsed_ns();
+}
+
+template<typename Stack>
+void report(const char* name, snw::page_allocator& allocator, size_t thread_count) {
+    Stack stack;
+
+    std::vector<snw::page*> pages;
+    for (size_t i = 0; i < node_count; ++i) {
+        snw::page* page = allocator.allocate();
+        pages.push_back(page);
+
+        snw::page_stack nodes;
+        nodes.push_back(page);
+        stack.push_node(nodes.detach_node());
+    }
+
+    double elapsed_ns = run(stack, thread_count);
+    double op_count = 2.0 * iteration_count * thread_count;
+
+    std::cout << std::setw(24) << name
+              << std::setw(10) << thread_count
+              << std::setw(14) << std::fixed << std::setprecision(1) << (elapsed_ns / op_count)
+              << std::setw(14) << std::fixed << std::setprecision(2) << (op_count / elapsed_ns * 1000.0)
+              << std::endl;
+
+    for (size_t i = 0; i < node_count; ++i) {
+        stack.pop_node();
+    }
+    for (snw::page* page: pages) {
+        allocator.deallocate(page);
+    }
+}
+
+}
+
+SNW_BENCHMARK(mem_concurrent_page_stack) {
+    snw::page_allocator allocator(snw::page_allocator::huge_page_size);
+
+    size_t max_thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << std::setw(24) << "stack"
+              << std::setw(10) << "threads"
+              << std::setw(14) << "ns/op"
+              << std::setw(14) << "Mops/s"
+              << std::endl;
+
+    for (size_t thread_count = 1; thread_count <= max_thread_count; thread_count *= 2) {
+        report<locked_page_stack>("locked_page_stack", allocator, thread_count);
+        report<snw::concurrent_page_stack>("concurrent_page_stack", allocator, thread_count);
+    }
+}
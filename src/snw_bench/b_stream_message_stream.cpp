@@ -0,0 +1,254 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include "bench.h"
+#include "message_stream.h"
+
+namespace {
+
+constexpr size_t stream_size = 1024 * 1024;
+constexpr size_t min_message_size = 8;
+constexpr size_t max_message_size = 4096;
+constexpr size_t throughput_bytes = 256 * 1024 * 1024;
+constexpr size_t max_throughput_count = 4 * 1024 * 1024;
+constexpr size_t latency_count = 100000;
+constexpr size_t publish_batch = 16;
+
+struct message {
+};
+
+struct pinning {
+    const char* name;
+    int         producer_cpu;
+    int         consumer_cpu; // -1 if the machine doesn't have one
+};
+
+std::vector<pinning> pinnings() {
+    return {
+        {"same core", 0, 0},
+        {"smt sibling", 0, snw::find_smt_sibling(0)},
+        {"cross socket", 0, snw::find_other_socket_cpu(0)},
+    };
+}
+
+size_t throughput_count(size_t message_size) {
+    return std::min(max_throughput_count, throughput_bytes / message_size);
+}
+
+uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void write_message(snw::atomic_message_stream<message>& stream, const uint8_t* payload, size_t message_size) {
+    snw::span<uint8_t> buf;
+    while (!(buf = stream.reserve(message_size))) {
+        std::this_thread::yield(); // needed when sharing a core
+    }
+
+    memcpy(buf.data(), payload, message_size);
+    stream.commit();
+}
+
+void print_throughput(const char* stream, const char* pinning, size_t message_size, size_t count, double elapsed_ns) {
+    std::cout << std::setw(24) << stream
+              << std::setw(14) << pinning
+              << std::setw(8) << message_size
+              << std::setw(12) << std::fixed << std::setprecision(2) << (count / elapsed_ns * 1000.0)
+              << std::setw(12) << std::fixed << std::setprecision(1) << (count * message_size / elapsed_ns * 1000.0)
+              << std::endl;
+}
+
+// The writer and reader take turns on one thread, a stream's worth of
+// messages at a time. This is the only way a byte_stream with a
+// local_sequence can be used, so it's the baseline for both.
+template<typename Stream>
+void single_thread_throughput(const char* name, size_t message_size, bool batched) {
+    Stream stream(stream_size);
+    std::vector<uint8_t> payload(message_size, 1);
+    size_t count = throughput_count(message_size);
+
+    snw::stopwatch stopwatch;
+    uint64_t sum = 0;
+    for (size_t written = 0; written < count;) {
+        for (; written < count; ++written) {
+            snw::span<uint8_t> buf = stream.reserve(message_size);
+            if (!buf) {
+                break;
+            }
+
+            memcpy(buf.data(), payload.data(), message_size);
+            stream.commit();
+        }
+
+        if (batched) {
+            auto batch = stream.read_batch();
+            for (auto it = batch.begin(); it != batch.end(); ++it) {
+                sum += it.payload()[0];
+            }
+            stream.commit_batch(batch);
+        }
+        else {
+            stream.read_span([&](snw::span<const uint8_t> data) {
+                sum += data[0];
+            });
+        }
+    }
+    double elapsed_ns = stopwatch.elapsed_ns();
+    snw::do_not_optimize(sum);
+
+    print_throughput(name, "one thread", message_size, count, elapsed_ns);
+}
+
+void cross_thread_throughput(const char* name, const pinning& pinning, size_t message_size, size_t batch) {
+    snw::atomic_message_stream<message> stream(stream_size);
+    stream.set_publish_batch(batch);
+    size_t count = throughput_count(message_size);
+
+    std::atomic<bool> ready(false);
+    std::thread consumer([&]() {
+        snw::pin_current_thread(pinning.consumer_cpu);
+        ready = true;
+
+        uint64_t sum = 0;
+        for (size_t read = 0; read < count;) {
+            size_t cnt = stream.read_span([&](snw::span<const uint8_t> data) {
+                sum += data[0];
+            });
+            if (cnt == 0) {
+                std::this_thread::yield();
+            }
+            read += cnt;
+        }
+        snw::do_not_optimize(sum);
+    });
+
+    snw::pin_current_thread(pinning.producer_cpu);
+    while (!ready) {
+        std::this_thread::yield();
+    }
+
+    std::vector<uint8_t> payload(message_size, 1);
+    snw::stopwatch stopwatch;
+    for (size_t i = 0; i < count; ++i) {
+        write_message(stream, payload.data(), message_size);
+    }
+    stream.flush();
+    consumer.join();
+    double elapsed_ns = stopwatch.elapsed_ns();
+
+    print_throughput(name, pinning.name, message_size, count, elapsed_ns);
+}
+
+// One message in flight at a time, so the numbers are the unloaded
+// one-way latency (from before reserve to the consumer's handler).
+void cross_thread_latency(const pinning& pinning, size_t message_size) {
+    snw::atomic_message_stream<message> stream(stream_size);
+    std::atomic<size_t> consumed(0);
+    std::vector<uint64_t> samples;
+    samples.reserve(latency_count);
+
+    std::atomic<bool> ready(false);
+    std::thread consumer([&]() {
+        snw::pin_current_thread(pinning.consumer_cpu);
+        ready = true;
+
+        while (samples.size() < latency_count) {
+            size_t cnt = stream.read_span([&](snw::span<const uint8_t> data) {
+                uint64_t sent;
+                memcpy(&sent, data.data(), sizeof(sent));
+                samples.push_back(now_ns() - sent);
+            });
+            if (cnt == 0) {
+                std::this_thread::yield();
+            }
+            consumed.fetch_add(cnt, std::memory_order_release);
+        }
+    });
+
+    snw::pin_current_thread(pinning.producer_cpu);
+    while (!ready) {
+        std::this_thread::yield();
+    }
+
+    std::vector<uint8_t> payload(message_size, 1);
+    for (size_t i = 0; i < latency_count; ++i) {
+        uint64_t sent = now_ns();
+        memcpy(payload.data(), &sent, sizeof(sent));
+        write_message(stream, payload.data(), message_size);
+
+        while (consumed.load(std::memory_order_acquire) <= i) {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))];
+    };
+
+    std::cout << std::setw(14) << pinning.name
+              << std::setw(8) << message_size
+              << std::setw(10) << percentile(0.5)
+              << std::setw(10) << percentile(0.9)
+              << std::setw(10) << percentile(0.99)
+              << std::setw(10) << percentile(0.999)
+              << std::setw(10) << samples.back()
+              << std::endl;
+}
+
+}
+
+SNW_BENCHMARK(stream_message_stream_throughput) {
+    std::cout << std::setw(24) << "stream"
+              << std::setw(14) << "pinning"
+              << std::setw(8) << "bytes"
+              << std::setw(12) << "Mmsgs/s"
+              << std::setw(12) << "MB/s"
+              << std::endl;
+
+    for (size_t message_size = min_message_size; message_size <= max_message_size; message_size *= 2) {
+        single_thread_throughput<snw::message_stream<message>>("message_stream", message_size, false);
+        single_thread_throughput<snw::message_stream<message>>("  read_batch", message_size, true);
+        single_thread_throughput<snw::atomic_message_stream<message>>("atomic_message_stream", message_size, false);
+    }
+
+    for (const pinning& pinning: pinnings()) {
+        if (pinning.consumer_cpu < 0) {
+            std::cout << std::setw(24) << "atomic_message_stream" << std::setw(14) << pinning.name << "  (no such cpu)" << std::endl;
+            continue;
+        }
+
+        for (size_t message_size = min_message_size; message_size <= max_message_size; message_size *= 2) {
+            cross_thread_throughput("atomic_message_stream", pinning, message_size, 1);
+            cross_thread_throughput("  publish batch 16", pinning, message_size, publish_batch);
+        }
+    }
+}
+
+SNW_BENCHMARK(stream_message_stream_latency) {
+    std::cout << std::setw(14) << "pinning"
+              << std::setw(8) << "bytes"
+              << std::setw(10) << "p50 ns"
+              << std::setw(10) << "p90 ns"
+              << std::setw(10) << "p99 ns"
+              << std::setw(10) << "p99.9 ns"
+              << std::setw(10) << "max ns"
+              << std::endl;
+
+    for (const pinning& pinning: pinnings()) {
+        if (pinning.consumer_cpu < 0) {
+            std::cout << std::setw(14) << pinning.name << "  (no such cpu)" << std::endl;
+            continue;
+        }
+
+        for (size_t message_size = min_message_size; message_size <= max_message_size; message_size *= 2) {
+            cross_thread_latency(pinning, message_size);
+        }
+    }
+}
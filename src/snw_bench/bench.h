@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace snw {
+
+using benchmark_function = void (*)();
+
+struct benchmark {
+    const char*        name;
+    benchmark_function function;
+};
+
+std::vector<benchmark>& benchmarks();
+
+struct benchmark_registrar {
+    benchmark_registrar(const char* name, benchmark_function function) {
+        benchmarks().push_back(benchmark{name, function});
+    }
+};
+
+class stopwatch {
+public:
+    using clock = std::chrono::steady_clock;
+
+    stopwatch()
+        : start_(clock::now())
+    {
+    }
+
+    void reset() {
+        start_ = clock::now();
+    }
+
+    double elapsed_ns() const {
+        return std::chrono::duration<double, std::nano>(clock::now() - start_).count();
+    }
+
+private:
+    clock::time_point start_;
+};
+
+// pin the calling thread to a cpu (returns false if that isn't possible)
+bool pin_current_thread(int cpu);
+
+// Another cpu on the same core as cpu (a hyperthread), or on a different
+// socket. Returns -1 if there isn't one.
+int find_smt_sibling(int cpu);
+int find_other_socket_cpu(int cpu);
+
+// keep the optimizer from discarding a value
+template<typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+}
+
+#define SNW_BENCHMARK(name) \
+    static void name(); \
+    static snw::benchmark_registrar name##_registrar(#name, &name); \
+    static void name()
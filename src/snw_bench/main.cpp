@@ -0,0 +1,131 @@
+#include <iostream>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include "bench.h"
+#include "platform.h"
+
+#if defined(SNW_OS_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+std::vector<snw::benchmark>& snw::benchmarks() {
+    static std::vector<benchmark> benchmarks;
+    return benchmarks;
+}
+
+bool snw::pin_current_thread(int cpu) {
+#if defined(SNW_OS_LINUX)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+    return false;
+#endif
+}
+
+#if defined(SNW_OS_LINUX)
+
+namespace {
+
+// reads a cpu topology attribute like "0" or a list like "0,4" or "0-1"
+std::vector<int> read_cpu_topology(int cpu, const char* name) {
+    std::vector<int> values;
+
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return values;
+    }
+
+    int first;
+    while (fscanf(file, "%d", &first) == 1) {
+        int last = first;
+        int c = fgetc(file);
+        if (c == '-') {
+            if (fscanf(file, "%d", &last) != 1) {
+                break;
+            }
+            c = fgetc(file);
+        }
+
+        for (int value = first; value <= last; ++value) {
+            values.push_back(value);
+        }
+
+        if (c != ',') {
+            break;
+        }
+    }
+    fclose(file);
+
+    return values;
+}
+
+}
+
+int snw::find_smt_sibling(int cpu) {
+    for (int sibling: read_cpu_topology(cpu, "thread_siblings_list")) {
+        if (sibling != cpu) {
+            return sibling;
+        }
+    }
+
+    return -1;
+}
+
+int snw::find_other_socket_cpu(int cpu) {
+    std::vector<int> package = read_cpu_topology(cpu, "physical_package_id");
+    if (package.empty()) {
+        return -1;
+    }
+
+    int cpu_count = static_cast<int>(std::thread::hardware_concurrency());
+    for (int other = 0; other < cpu_count; ++other) {
+        std::vector<int> other_package = read_cpu_topology(other, "physical_package_id");
+        if (!other_package.empty() && (other_package[0] != package[0])) {
+            return other;
+        }
+    }
+
+    return -1;
+}
+
+#else
+
+int snw::find_smt_sibling(int cpu) {
+    return -1;
+}
+
+int snw::find_other_socket_cpu(int cpu) {
+    return -1;
+}
+
+#endif
+
+// usage: snw_bench [name-substring...]
+int main(int argc, char** argv) {
+    try {
+        for (const snw::benchmark& benchmark: snw::benchmarks()) {
+            bool selected = (argc <= 1);
+            for (int i = 1; i < argc; ++i) {
+                selected |= (strstr(benchmark.name, argv[i]) != nullptr);
+            }
+
+            if (selected) {
+                std::cout << "== " << benchmark.name << std::endl;
+                benchmark.function();
+                std::cout << std::endl;
+            }
+        }
+    }
+    catch (const std::exception& ex) {
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,2 +1,3 @@
+#define CATCH_CONFIG_NO_POSIX_SIGNALS // glibc >= 2.34 makes MINSIGSTKSZ non-constant
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
\ No newline at end of file
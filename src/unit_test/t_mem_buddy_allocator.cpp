@@ -0,0 +1,119 @@
+#include "catch.hpp"
+#include "buddy_allocator.h"
+#include "page_allocator.h"
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+TEST_CASE("buddy_allocator") {
+    static constexpr size_t page_count = 4 * snw::buddy_allocator::max_span_size;
+
+    snw::page_allocator pages(page_count * sizeof(snw::page));
+    snw::page* region = pages.allocate_contiguous(page_count);
+    REQUIRE(region);
+
+    SECTION("span sizes") {
+        CHECK(snw::buddy_allocator::span_size(0) == 1);
+        CHECK(snw::buddy_allocator::span_size(1) == 1);
+        CHECK(snw::buddy_allocator::span_size(2) == 2);
+        CHECK(snw::buddy_allocator::span_size(3) == 4);
+        CHECK(snw::buddy_allocator::span_size(512) == 512);
+    }
+
+    SECTION("split and coalesce") {
+        snw::buddy_allocator buddy(region, page_count);
+        CHECK(buddy.capacity() == page_count);
+
+        // lowest addresses are handed out first
+        snw::page* a = buddy.allocate(1);
+        snw::page* b = buddy.allocate(1);
+        snw::page* c = buddy.allocate(2);
+        CHECK(a == region);
+        CHECK(b == (region + 1));
+        CHECK(c == (region + 2));
+        CHECK(buddy.size() == 4);
+
+        // freeing everything should coalesce back into whole max spans
+        buddy.deallocate(b, 1);
+        buddy.deallocate(a, 1);
+        buddy.deallocate(c, 2);
+        CHECK(buddy.size() == 0);
+
+        std::vector<snw::page*> spans;
+        while (snw::page* span = buddy.allocate(snw::buddy_allocator::max_span_size)) {
+            spans.push_back(span);
+        }
+        CHECK(spans.size() == 4);
+        for (snw::page* span: spans) {
+            buddy.deallocate(span, snw::buddy_allocator::max_span_size);
+        }
+    }
+
+    SECTION("too big") {
+        snw::buddy_allocator buddy(region, page_count);
+        CHECK(!buddy.allocate(snw::buddy_allocator::max_span_size + 1));
+    }
+
+    SECTION("odd sized region") {
+        snw::buddy_allocator buddy(region, 7);
+
+        CHECK(buddy.allocate(4) == region);
+        CHECK(buddy.allocate(2) == (region + 4));
+        CHECK(buddy.allocate(1) == (region + 6));
+        CHECK(!buddy.allocate(1));
+
+        buddy.deallocate(region + 4, 2);
+        buddy.deallocate(region, 4);
+        buddy.deallocate(region + 6, 1);
+        CHECK(!buddy.allocate(8));
+    }
+
+    SECTION("exhaust and refill") {
+        snw::buddy_allocator buddy(region, page_count);
+
+        // a deterministic mix of span sizes
+        std::vector<std::pair<snw::page*, size_t>> spans;
+        uint32_t state = 7;
+        size_t allocated = 0;
+        for (;;) {
+            state = state * 1103515245 + 12345;
+            size_t span_size = 1 + ((state >> 16) % 40);
+            snw::page* span = buddy.allocate(span_size);
+            if (!span) {
+                break;
+            }
+
+            // spans must be aligned to their size and must not overlap
+            size_t size = snw::buddy_allocator::span_size(span_size);
+            REQUIRE(((span - region) % size) == 0);
+            for (auto& other: spans) {
+                size_t other_size = snw::buddy_allocator::span_size(other.second);
+                REQUIRE(((span + size) <= other.first || (other.first + other_size) <= span));
+            }
+
+            spans.emplace_back(span, span_size);
+            allocated += size;
+        }
+        CHECK(buddy.size() == allocated);
+
+        std::reverse(spans.begin(), spans.end());
+        for (size_t i = 0; i < spans.size(); i += 2) {
+            buddy.deallocate(spans[i].first, spans[i].second);
+        }
+        for (size_t i = 1; i < spans.size(); i += 2) {
+            buddy.deallocate(spans[i].first, spans[i].second);
+        }
+        CHECK(buddy.size() == 0);
+
+        // should have coalesced all the way back up
+        for (int i = 0; i < 4; ++i) {
+            CHECK(buddy.allocate(snw::buddy_allocator::max_span_size) == (region + (i * snw::buddy_allocator::max_span_size)));
+        }
+        for (int i = 0; i < 4; ++i) {
+            buddy.deallocate(region + (i * snw::buddy_allocator::max_span_size), snw::buddy_allocator::max_span_size);
+        }
+    }
+
+    pages.deallocate_contiguous(region, page_count);
+    CHECK(pages.size() == 0);
+}
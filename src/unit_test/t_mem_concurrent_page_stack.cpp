@@ -0,0 +1,99 @@
+#include "catch.hpp"
+#include "concurrent_page_stack.h"
+#include "page_allocator.h"
+#include <vector>
+#include <thread>
+#include <set>
+
+namespace {
+
+snw::page* make_node(snw::page_allocator& allocator, size_t page_count) {
+    snw::page_stack pages;
+    for (size_t i = 0; i < page_count; ++i) {
+        pages.push_back(allocator.allocate());
+    }
+
+    return pages.detach_node();
+}
+
+void free_node(snw::page_allocator& allocator, snw::page* node) {
+    snw::page_stack pages;
+    pages.attach_node(node);
+    while (snw::page* page = pages.pop_back()) {
+        allocator.deallocate(page);
+    }
+}
+
+}
+
+TEST_CASE("concurrent_page_stack") {
+    snw::page_allocator allocator(snw::page_allocator::huge_page_size * 4);
+
+    SECTION("default constructed") {
+        snw::concurrent_page_stack stack;
+
+        CHECK(stack.empty());
+        CHECK(stack.size() == 0);
+        CHECK(!stack.pop_node());
+    }
+
+    SECTION("push and pop") {
+        snw::concurrent_page_stack stack;
+
+        snw::page* node1 = make_node(allocator, 3);
+        snw::page* node2 = make_node(allocator, snw::page_stack::max_node_size);
+
+        stack.push_node(node1);
+        stack.push_node(node2);
+        CHECK(!stack.empty());
+        CHECK(stack.size() == (3 + snw::page_stack::max_node_size));
+
+        CHECK(stack.pop_node() == node2);
+        CHECK(stack.pop_node() == node1);
+        CHECK(!stack.pop_node());
+        CHECK(stack.empty());
+        CHECK(stack.size() == 0);
+
+        free_node(allocator, node1);
+        free_node(allocator, node2);
+    }
+
+    SECTION("multiple threads") {
+        static constexpr size_t node_count = 16;
+        static constexpr size_t thread_count = 4;
+        static constexpr size_t iteration_count = 100000;
+
+        snw::concurrent_page_stack stack;
+        for (size_t i = 0; i < node_count; ++i) {
+            stack.push_node(make_node(allocator, 2));
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back([&stack]() {
+                for (size_t j = 0; j < iteration_count; ++j) {
+                    if (snw::page* node = stack.pop_node()) {
+                        stack.push_node(node);
+                    }
+                }
+            });
+        }
+        for (std::thread& thread: threads) {
+            thread.join();
+        }
+
+        // every node should still be there exactly once
+        std::set<snw::page*> nodes;
+        while (snw::page* node = stack.pop_node()) {
+            CHECK(nodes.insert(node).second);
+        }
+        CHECK(nodes.size() == node_count);
+        CHECK(stack.size() == 0);
+
+        for (snw::page* node: nodes) {
+            free_node(allocator, node);
+        }
+    }
+
+    CHECK(allocator.size() == 0);
+}
@@ -0,0 +1,64 @@
+#include "catch.hpp"
+#include "numa_page_pool.h"
+#include "page_cache.h"
+#include <vector>
+
+TEST_CASE("numa_page_pool") {
+    snw::numa_page_pool pools(snw::page_allocator::huge_page_size * 2);
+
+    REQUIRE(pools.node_count() >= 1);
+    CHECK(pools.node_count() == snw::get_numa_node_count());
+
+    SECTION("local") {
+        snw::numa_node_id node = snw::get_current_numa_node();
+        REQUIRE(node >= 0);
+        REQUIRE(node < pools.node_count());
+        CHECK(&pools.local() == &pools.pool(node));
+
+        snw::page_cache cache(pools.local());
+        snw::page* page = cache.allocate();
+        REQUIRE(page);
+        CHECK(pools.node_of(page) == node);
+
+        cache.deallocate(page);
+    }
+
+    SECTION("explicit placement and stats") {
+        for (snw::numa_node_id node = 0; node < pools.node_count(); ++node) {
+            snw::numa_node_stats stats = pools.stats(node);
+            CHECK(stats.capacity == ((snw::page_allocator::huge_page_size * 2) / sizeof(snw::page)));
+            CHECK(stats.allocated == 0);
+            CHECK(stats.pooled == 0);
+
+            std::vector<snw::page*> pages;
+            {
+                snw::page_cache cache(pools.pool(node));
+                for (size_t i = 0; i < 100; ++i) {
+                    snw::page* page = cache.allocate();
+                    REQUIRE(page);
+                    CHECK(pools.node_of(page) == node);
+                    page->data[0] = 1;
+                    pages.push_back(page);
+                }
+
+                stats = pools.stats(node);
+                CHECK(stats.allocated == snw::page_stack::max_node_size);
+                CHECK(stats.pooled == 0);
+
+                for (snw::page* page: pages) {
+                    cache.deallocate(page);
+                }
+            }
+
+            // the cache gives everything back to the pool when it goes away
+            stats = pools.stats(node);
+            CHECK(stats.allocated == snw::page_stack::max_node_size);
+            CHECK(stats.pooled == snw::page_stack::max_node_size);
+        }
+    }
+
+    SECTION("foreign pages") {
+        snw::page page;
+        CHECK(pools.node_of(&page) == -1);
+    }
+}
@@ -0,0 +1,197 @@
+#include "catch.hpp"
+#include "page_allocator.h"
+#include "align.h"
+#include <vector>
+#include <set>
+#include <stdexcept>
+#include <cstdlib>
+#include <unistd.h>
+
+TEST_CASE("page_allocator") {
+    SECTION("construction") {
+        snw::page_allocator allocator(1);
+
+        CHECK(allocator.size() == 0);
+        CHECK(allocator.capacity() == (snw::page_allocator::huge_page_size / sizeof(snw::page)));
+    }
+
+    SECTION("huge page alignment") {
+        snw::page_allocator allocator(snw::page_allocator::huge_page_size * 2);
+
+        snw::page* page = allocator.allocate();
+        REQUIRE(page);
+        CHECK(snw::is_aligned(page, snw::page_allocator::huge_page_size));
+        CHECK(allocator.owns(page));
+
+        allocator.deallocate(page);
+    }
+
+    SECTION("exhaustion") {
+        snw::page_allocator allocator(1, snw::huge_page_mode::none);
+
+        std::vector<snw::page*> pages;
+        std::set<snw::page*> unique_pages;
+        while (snw::page* page = allocator.allocate()) {
+            page->data[0] = 1; // touch it
+            pages.push_back(page);
+            unique_pages.insert(page);
+        }
+
+        CHECK(pages.size() == allocator.capacity());
+        CHECK(unique_pages.size() == allocator.capacity());
+        CHECK(allocator.size() == allocator.capacity());
+        CHECK(!allocator.allocate());
+
+        for (snw::page* page: pages) {
+            allocator.deallocate(page);
+        }
+
+        CHECK(allocator.size() == 0);
+    }
+
+    SECTION("recycling") {
+        snw::page_allocator allocator(1);
+
+        // freed pages should be handed out again (most recently freed first)
+        snw::page* page1 = allocator.allocate();
+        snw::page* page2 = allocator.allocate();
+        allocator.deallocate(page1);
+        allocator.deallocate(page2);
+
+        CHECK(allocator.allocate() == page2);
+        CHECK(allocator.allocate() == page1);
+
+        allocator.deallocate(page1);
+        allocator.deallocate(page2);
+
+        // recycle enough pages that the free page stack needs several nodes
+        std::vector<snw::page*> pages;
+        for (size_t i = 0; i < allocator.capacity(); ++i) {
+            pages.push_back(allocator.allocate());
+        }
+        for (snw::page* page: pages) {
+            allocator.deallocate(page);
+        }
+        for (size_t i = 0; i < allocator.capacity(); ++i) {
+            REQUIRE(allocator.allocate() == pages[pages.size() - i - 1]);
+        }
+        CHECK(!allocator.allocate());
+        for (snw::page* page: pages) {
+            allocator.deallocate(page);
+        }
+    }
+
+    SECTION("contiguous") {
+        static constexpr size_t huge_page_count = snw::page_allocator::huge_page_size / sizeof(snw::page);
+
+        snw::page_allocator allocator(snw::page_allocator::huge_page_size * 2);
+
+        // the span starts on the next huge page, but the skipped pages are still usable
+        snw::page* page = allocator.allocate();
+        snw::page* span = allocator.allocate_contiguous(huge_page_count);
+        REQUIRE(span);
+        CHECK(span == (page + huge_page_count));
+        CHECK(snw::is_aligned(span, snw::page_allocator::huge_page_size));
+        CHECK(!allocator.allocate_contiguous(1));
+        CHECK(allocator.size() == (huge_page_count + 1));
+
+        std::vector<snw::page*> pages;
+        while (snw::page* other = allocator.allocate()) {
+            CHECK(!((span <= other) && (other < (span + huge_page_count))));
+            pages.push_back(other);
+        }
+        CHECK(pages.size() == (huge_page_count - 1));
+
+        allocator.deallocate(page);
+        allocator.deallocate_contiguous(span, huge_page_count);
+        for (snw::page* other: pages) {
+            allocator.deallocate(other);
+        }
+        CHECK(allocator.size() == 0);
+    }
+
+    SECTION("trim watermark") {
+        snw::page_allocator allocator(snw::page_allocator::huge_page_size * 4);
+        allocator.set_trim_watermark(100);
+
+        std::vector<snw::page*> pages;
+        while (snw::page* page = allocator.allocate()) {
+            page->data[0] = 1;
+            pages.push_back(page);
+        }
+        for (snw::page* page: pages) {
+            allocator.deallocate(page);
+        }
+
+        // only checked at node boundaries, so it can lag a little
+        const snw::page_trim_stats& stats = allocator.trim_stats();
+        CHECK(stats.trimmed > 0);
+        CHECK(stats.trimmed <= (pages.size() - 100));
+        CHECK(stats.refaulted == 0);
+
+        for (size_t i = 0; i < pages.size(); ++i) {
+            REQUIRE(allocator.allocate());
+        }
+        CHECK(stats.refaulted == stats.trimmed);
+
+        for (snw::page* page: pages) {
+            allocator.deallocate(page);
+        }
+    }
+
+    SECTION("file backed") {
+        static constexpr size_t max_size = snw::page_allocator::huge_page_size;
+
+        char path[] = "/tmp/snw_page_allocator_XXXXXX";
+        int fd = mkstemp(path);
+        REQUIRE(fd >= 0);
+
+        size_t root_index;
+        size_t free_index;
+        {
+            snw::page_allocator allocator(fd, max_size);
+            CHECK(allocator.file_backed());
+            CHECK(snw::is_aligned(allocator.page_at(0), snw::page_allocator::huge_page_size));
+            CHECK(allocator.size() == 0);
+            CHECK(!allocator.root());
+
+            snw::page* root = allocator.allocate();
+            snw::page* child = allocator.allocate();
+            snw::page* other = allocator.allocate();
+            snw::page* last = allocator.allocate();
+            REQUIRE(last);
+
+            // link the pages by index since the next mapping can move
+            root_index = allocator.index_of(root);
+            reinterpret_cast<size_t*>(root->data)[0] = allocator.index_of(child);
+            child->data[0] = 42;
+            allocator.set_root(root);
+
+            free_index = allocator.index_of(other);
+            allocator.deallocate(other);
+        }
+
+        {
+            snw::page_allocator allocator(path, max_size);
+            CHECK(allocator.size() == 3);
+
+            snw::page* root = allocator.root();
+            REQUIRE(root);
+            CHECK(allocator.index_of(root) == root_index);
+
+            snw::page* child = allocator.page_at(reinterpret_cast<size_t*>(root->data)[0]);
+            CHECK(child->data[0] == 42);
+
+            // the hole left by the freed page is used before the untouched pages
+            snw::page* page = allocator.allocate();
+            CHECK(allocator.index_of(page) == free_index);
+            CHECK(allocator.index_of(allocator.allocate()) == (root_index + 4));
+            CHECK(allocator.size() == 5);
+        }
+
+        CHECK_THROWS_AS(snw::page_allocator(path, max_size * 2), std::runtime_error);
+
+        close(fd);
+        unlink(path);
+    }
+}
@@ -0,0 +1,127 @@
+#include "catch.hpp"
+#include "page_cache.h"
+#include <vector>
+#include <thread>
+
+TEST_CASE("page_cache") {
+    SECTION("refill and drain") {
+        snw::page_allocator allocator(snw::page_allocator::huge_page_size * 4);
+        {
+            snw::page_pool pool(allocator);
+            snw::page_cache cache(pool, snw::page_stack::max_node_size);
+
+            // the first allocation pulls a whole node out of the pool
+            std::vector<snw::page*> pages;
+            pages.push_back(cache.allocate());
+            REQUIRE(pages.back());
+            CHECK(cache.size() == (snw::page_stack::max_node_size - 1));
+            CHECK(allocator.size() == snw::page_stack::max_node_size);
+
+            for (size_t i = 0; i < (snw::page_stack::max_node_size * 3); ++i) {
+                pages.push_back(cache.allocate());
+                REQUIRE(pages.back());
+            }
+
+            // returning everything should spill whole nodes back to the pool
+            for (snw::page* page: pages) {
+                cache.deallocate(page);
+            }
+            CHECK(cache.size() <= (2 * snw::page_stack::max_node_size));
+            CHECK(pool.size() > 0);
+            CHECK((pool.size() % snw::page_stack::max_node_size) == 0);
+            CHECK((cache.size() + pool.size()) == allocator.size());
+        }
+        CHECK(allocator.size() == 0);
+    }
+
+    SECTION("exhaustion") {
+        snw::page_allocator allocator(1);
+        {
+            snw::page_pool pool(allocator);
+            snw::page_cache cache(pool);
+
+            std::vector<snw::page*> pages;
+            while (snw::page* page = cache.allocate()) {
+                pages.push_back(page);
+            }
+            CHECK(pages.size() == allocator.capacity());
+
+            for (snw::page* page: pages) {
+                cache.deallocate(page);
+            }
+        }
+        CHECK(allocator.size() == 0);
+    }
+
+    SECTION("multiple threads") {
+        static constexpr size_t thread_count = 4;
+        static constexpr size_t page_count = 500;
+
+        snw::page_allocator allocator(snw::page_allocator::huge_page_size * 16);
+        {
+            snw::page_pool pool(allocator);
+
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < thread_count; ++i) {
+                threads.emplace_back([&pool]() {
+                    snw::page_cache cache(pool);
+                    std::vector<snw::page*> pages;
+                    for (int round = 0; round < 10; ++round) {
+                        for (size_t j = 0; j < page_count; ++j) {
+                            snw::page* page = cache.allocate();
+                            assert(page);
+                            page->data[0] = static_cast<uint8_t>(j);
+                            pages.push_back(page);
+                        }
+                        for (snw::page* page: pages) {
+                            cache.deallocate(page);
+                        }
+                        pages.clear();
+                    }
+                });
+            }
+
+            for (std::thread& thread: threads) {
+                thread.join();
+            }
+
+            CHECK(pool.size() == allocator.size());
+        }
+        CHECK(allocator.size() == 0);
+    }
+
+    SECTION("trim watermark") {
+        snw::page_allocator allocator(snw::page_allocator::huge_page_size * 4);
+        {
+            snw::page_pool pool(allocator, snw::page_stack::max_node_size);
+            {
+                snw::page_cache cache(pool, snw::page_stack::max_node_size);
+
+                std::vector<snw::page*> pages;
+                while (snw::page* page = cache.allocate()) {
+                    page->data[0] = 1;
+                    pages.push_back(page);
+                }
+                for (snw::page* page: pages) {
+                    cache.deallocate(page);
+                }
+            }
+
+            // nodes pushed beyond the first one should have been trimmed
+            CHECK(pool.size() == allocator.capacity());
+            CHECK(pool.trimmed() > 0);
+            CHECK(pool.trimmed() < allocator.capacity());
+
+            snw::page_cache cache(pool);
+            std::vector<snw::page*> pages;
+            while (snw::page* page = cache.allocate()) {
+                pages.push_back(page);
+            }
+            CHECK(cache.trim_stats().refaulted == pool.trimmed());
+            for (snw::page* page: pages) {
+                cache.deallocate(page);
+            }
+        }
+        CHECK(allocator.size() == 0);
+    }
+}
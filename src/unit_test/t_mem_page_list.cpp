@@ -1,11 +1,156 @@
 #include "catch.hpp"
 #include "page_list.h"
+#include <vector>
+#include <deque>
+
+namespace {
+
+bool equals(const snw::page_list& pl, const std::deque<snw::page*>& expected) {
+    if (pl.size() != expected.size()) {
+        return false;
+    }
+
+    std::vector<snw::page*> forward(pl.begin(), pl.end());
+    if (!std::equal(forward.begin(), forward.end(), expected.begin())) {
+        return false;
+    }
+
+    // and walk it backwards
+    std::vector<snw::page*> backward;
+    for (auto it = pl.end(); it != pl.begin(); ) {
+        backward.push_back(*--it);
+    }
+    return std::equal(backward.begin(), backward.end(), expected.rbegin());
+}
+
+}
 
 TEST_CASE("page_list") {
+    std::vector<snw::page> pages(2000);
+
     SECTION("default constructed") {
         snw::page_list pl;
+
+        CHECK(pl.empty());
+        CHECK(pl.size() == 0);
+        CHECK(pl.begin() == pl.end());
     }
 
     SECTION("push_back") {
+        snw::page_list pl;
+        for (snw::page& page: pages) {
+            pl.push_back(&page);
+        }
+
+        REQUIRE(pl.size() == pages.size());
+        size_t i = 0;
+        for (snw::page* page: pl) {
+            REQUIRE(page == &pages[i++]);
+        }
+
+        for (snw::page& page: pages) {
+            REQUIRE(pl.pop_front() == &page);
+        }
+        CHECK(pl.empty());
+    }
+
+    SECTION("push_front") {
+        snw::page_list pl;
+        for (snw::page& page: pages) {
+            pl.push_front(&page);
+        }
+
+        REQUIRE(pl.size() == pages.size());
+        for (snw::page& page: pages) {
+            REQUIRE(pl.pop_back() == &page);
+        }
+        CHECK(pl.empty());
+    }
+
+    SECTION("matches std::deque") {
+        snw::page_list pl;
+        std::deque<snw::page*> expected;
+
+        // a deterministic mix of operations at both ends
+        uint32_t state = 1;
+        size_t next_page = 0;
+        for (int i = 0; i < 20000; ++i) {
+            state = state * 1103515245 + 12345;
+            int op = (state >> 16) % 4;
+
+            if ((op < 2) && (next_page < pages.size())) {
+                snw::page* page = &pages[next_page++];
+                if (op == 0) {
+                    pl.push_front(page);
+                    expected.push_front(page);
+                }
+                else {
+                    pl.push_back(page);
+                    expected.push_back(page);
+                }
+            }
+            else if (!expected.empty()) {
+                if (op == 2) {
+                    REQUIRE(pl.pop_front() == expected.front());
+                    expected.pop_front();
+                }
+                else {
+                    REQUIRE(pl.pop_back() == expected.back());
+                    expected.pop_back();
+                }
+
+                // recycle popped pages once everything has been pushed
+                if (next_page == pages.size()) {
+                    next_page = 0;
+                    while (!expected.empty()) {
+                        REQUIRE(pl.pop_back() == expected.back());
+                        expected.pop_back();
+                    }
+                }
+            }
+
+            if ((i % 1000) == 0) {
+                REQUIRE(equals(pl, expected));
+            }
+        }
+
+        REQUIRE(equals(pl, expected));
+        while (!expected.empty()) {
+            REQUIRE(pl.pop_front() == expected.front());
+            expected.pop_front();
+        }
+        CHECK(pl.empty());
+    }
+
+    SECTION("splice") {
+        snw::page_list pl1;
+        snw::page_list pl2;
+        std::deque<snw::page*> expected;
+
+        for (size_t i = 0; i < 1000; ++i) {
+            pl1.push_back(&pages[i]);
+        }
+        for (size_t i = 1000; i < 2000; ++i) {
+            pl2.push_back(&pages[i]);
+        }
+        for (snw::page& page: pages) {
+            expected.push_back(&page);
+        }
+
+        pl1.splice_back(pl2);
+        CHECK(pl2.empty());
+        CHECK(pl2.size() == 0);
+        REQUIRE(equals(pl1, expected));
+
+        // pull half off the front and splice it back on
+        for (size_t i = 0; i < 1000; ++i) {
+            pl2.push_back(pl1.pop_front());
+        }
+        pl1.splice_front(pl2);
+        REQUIRE(equals(pl1, expected));
+
+        while (!pl1.empty()) {
+            pl1.pop_back();
+        }
     }
-}
\ No newline at end of file
+}
@@ -1,5 +1,7 @@
 #include "catch.hpp"
 #include "page_stack.h"
+#include "page_allocator.h"
+#include <vector>
 
 TEST_CASE("page_stack") {
     SECTION("default constructed") {
@@ -56,4 +58,78 @@ TEST_CASE("page_stack") {
 
         REQUIRE(page_stack2.empty());
     }
-}
\ No newline at end of file
+
+    SECTION("detach and attach") {
+        std::vector<snw::page> pages(snw::page_stack::max_node_size + 8);
+
+        snw::page_stack page_stack1;
+        for(snw::page& page: pages) {
+            page_stack1.push_back(&page);
+        }
+        REQUIRE(page_stack1.size() == pages.size());
+
+        // the top node holds the 8 most recently pushed pages
+        snw::page* node = page_stack1.detach_node();
+        REQUIRE(node);
+        CHECK(snw::page_stack::node_size(node) == 8);
+        CHECK(page_stack1.size() == snw::page_stack::max_node_size);
+
+        snw::page_stack page_stack2;
+        page_stack2.attach_node(node);
+        CHECK(page_stack2.size() == 8);
+
+        for(size_t i = 0; i < 8; ++i) {
+            REQUIRE(page_stack2.pop_back() == &pages[pages.size() - i - 1]);
+        }
+        REQUIRE(page_stack2.empty());
+
+        // the remaining node is full
+        node = page_stack1.detach_node();
+        REQUIRE(node);
+        CHECK(snw::page_stack::node_size(node) == snw::page_stack::max_node_size);
+        CHECK(page_stack1.empty());
+        CHECK(!page_stack1.detach_node());
+
+        page_stack2.attach_node(node);
+        for(size_t i = 0; i < snw::page_stack::max_node_size; ++i) {
+            REQUIRE(page_stack2.pop_back() == &pages[snw::page_stack::max_node_size - i - 1]);
+        }
+        REQUIRE(page_stack2.empty());
+        REQUIRE(page_stack2.size() == 0);
+    }
+
+    SECTION("trim") {
+        static constexpr size_t page_count = 3 * snw::page_stack::max_node_size;
+
+        snw::page_allocator allocator(page_count * sizeof(snw::page));
+        std::vector<snw::page*> pages;
+        for (size_t i = 0; i < page_count; ++i) {
+            pages.push_back(allocator.allocate());
+            pages.back()->data[0] = 1;
+        }
+
+        snw::page_stack page_stack;
+        for (snw::page* page: pages) {
+            page_stack.push_back(page);
+        }
+
+        // everything but the 100 newest pages (which include the top node) and the other 2 node pages
+        size_t trimmed = page_stack.trim(100);
+        CHECK(trimmed == (page_count - 100 - 2));
+        CHECK(page_stack.trim_stats().trimmed == trimmed);
+        CHECK(page_stack.trim_stats().refaulted == 0);
+
+        // trimming again is a no-op
+        CHECK(page_stack.trim(100) == 0);
+        CHECK(page_stack.trim(1000) == 0);
+
+        for (size_t i = 0; i < page_count; ++i) {
+            REQUIRE(page_stack.pop_back() == pages[page_count - i - 1]);
+        }
+        CHECK(page_stack.trim_stats().refaulted == trimmed);
+
+        for (snw::page* page: pages) {
+            allocator.deallocate(page);
+        }
+    }
+}
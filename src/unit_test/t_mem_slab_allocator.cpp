@@ -0,0 +1,187 @@
+#include "catch.hpp"
+#include "slab_allocator.h"
+#include "slab_cache.h"
+#include "page_allocator.h"
+#include "align.h"
+#include <vector>
+#include <thread>
+#include <set>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace {
+
+struct slab_fixture {
+    static constexpr size_t page_count = 2048;
+
+    snw::page_allocator   pages;
+    snw::page*            region;
+    snw::buddy_allocator* spans;
+
+    slab_fixture()
+        : pages(page_count * sizeof(snw::page))
+        , region(pages.allocate_contiguous(page_count))
+        , spans(new snw::buddy_allocator(region, page_count))
+    {
+    }
+
+    ~slab_fixture() {
+        delete spans;
+        pages.deallocate_contiguous(region, page_count);
+    }
+};
+
+}
+
+TEST_CASE("slab_allocator") {
+    slab_fixture fixture;
+
+    SECTION("size classes") {
+        CHECK(snw::slab_allocator::size_class_of(0) == 0);
+        CHECK(snw::slab_allocator::size_class_of(16) == 0);
+        CHECK(snw::slab_allocator::size_class_of(17) == 1);
+        CHECK(snw::slab_allocator::size_class_of(2048) == (snw::slab_allocator::size_class_count - 1));
+        CHECK(snw::slab_allocator::class_size(0) == 16);
+        CHECK(snw::slab_allocator::max_size == 2048);
+    }
+
+    SECTION("allocate and deallocate") {
+        snw::slab_allocator allocator(*fixture.spans);
+
+        CHECK(!allocator.allocate(snw::slab_allocator::max_size + 1));
+
+        for (size_t size = 1; size <= snw::slab_allocator::max_size; size *= 3) {
+            int size_class = snw::slab_allocator::size_class_of(size);
+
+            std::vector<void*> objects;
+            std::set<void*> unique_objects;
+            for (int i = 0; i < 1000; ++i) {
+                void* object = allocator.allocate(size);
+                REQUIRE(object);
+                memset(object, i, size);
+                objects.push_back(object);
+                unique_objects.insert(object);
+            }
+            CHECK(unique_objects.size() == objects.size());
+            CHECK(allocator.size(size_class) == objects.size());
+
+            // nothing should have been clobbered
+            for (int i = 0; i < 1000; ++i) {
+                REQUIRE(static_cast<uint8_t*>(objects[i])[0] == static_cast<uint8_t>(i));
+                REQUIRE(static_cast<uint8_t*>(objects[i])[size - 1] == static_cast<uint8_t>(i));
+            }
+
+            for (void* object: objects) {
+                allocator.deallocate(object, size);
+            }
+            CHECK(allocator.size(size_class) == 0);
+        }
+
+        // at most one empty slab per size class is kept
+        CHECK(fixture.spans->size() <= 32);
+    }
+
+    SECTION("exhaustion") {
+        snw::slab_allocator allocator(*fixture.spans);
+
+        std::vector<void*> objects;
+        while (void* object = allocator.allocate(snw::slab_allocator::max_size)) {
+            objects.push_back(object);
+        }
+        CHECK(!objects.empty());
+        CHECK(fixture.spans->size() == fixture.spans->capacity());
+
+        for (void* object: objects) {
+            allocator.deallocate(object, snw::slab_allocator::max_size);
+        }
+    }
+
+    CHECK(fixture.spans->size() == 0);
+}
+
+TEST_CASE("slab_allocator on a file backed arena") {
+    static constexpr size_t page_count = 2048;
+
+    char path[] = "/tmp/snw_slab_allocator_XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+
+    {
+        snw::page_allocator pages(fd, 2 * page_count * sizeof(snw::page));
+
+        // a page in the way, so the region has to be aligned past it
+        snw::page* page = pages.allocate();
+        snw::page* region = pages.allocate_contiguous(page_count);
+        REQUIRE(region);
+        CHECK(snw::is_aligned(region, snw::page_allocator::huge_page_size));
+
+        {
+            snw::buddy_allocator spans(region, page_count);
+            snw::slab_allocator allocator(spans);
+
+            std::vector<std::pair<void*, size_t>> objects;
+            for (size_t i = 0; i < 1000; ++i) {
+                size_t size = 1 + ((i * 37) % snw::slab_allocator::max_size);
+                void* object = allocator.allocate(size);
+                REQUIRE(object);
+                memset(object, static_cast<int>(i), size);
+                objects.emplace_back(object, size);
+            }
+            for (auto& object: objects) {
+                allocator.deallocate(object.first, object.second);
+            }
+
+            for (int i = 0; i < snw::slab_allocator::size_class_count; ++i) {
+                CHECK(allocator.size(i) == 0);
+            }
+        }
+
+        pages.deallocate_contiguous(region, page_count);
+        pages.deallocate(page);
+    }
+
+    close(fd);
+    unlink(path);
+}
+
+TEST_CASE("slab_cache") {
+    slab_fixture fixture;
+
+    SECTION("multiple threads") {
+        static constexpr size_t thread_count = 4;
+
+        snw::slab_allocator allocator(*fixture.spans);
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back([&allocator, i]() {
+                snw::slab_cache cache(allocator);
+
+                std::vector<std::pair<void*, size_t>> objects;
+                for (int round = 0; round < 20; ++round) {
+                    for (size_t j = 0; j < 500; ++j) {
+                        size_t size = 8 + ((i * 31 + j * 17) % 500);
+                        void* object = cache.allocate(size);
+                        assert(object);
+                        memset(object, static_cast<int>(j), size);
+                        objects.emplace_back(object, size);
+                    }
+                    for (auto& object: objects) {
+                        cache.deallocate(object.first, object.second);
+                    }
+                    objects.clear();
+                }
+            });
+        }
+        for (std::thread& thread: threads) {
+            thread.join();
+        }
+
+        for (int i = 0; i < snw::slab_allocator::size_class_count; ++i) {
+            CHECK(allocator.size(i) == 0);
+        }
+    }
+
+    CHECK(fixture.spans->size() == 0);
+}
@@ -0,0 +1,89 @@
+#include "catch.hpp"
+#include "zeroed_page_pool.h"
+#include "page_cache.h"
+#include <vector>
+#include <thread>
+#include <chrono>
+
+namespace {
+
+bool is_zeroed(const snw::page* page) {
+    for (uint8_t byte: page->data) {
+        if (byte != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}
+
+TEST_CASE("zeroed_page_pool") {
+    snw::page_allocator allocator(snw::page_allocator::huge_page_size * 4);
+
+    SECTION("zero_page") {
+        snw::page* page = allocator.allocate();
+        memset(page, 0xff, sizeof(*page));
+
+        snw::zero_page(page);
+        _mm_sfence();
+        CHECK(is_zeroed(page));
+
+        allocator.deallocate(page);
+    }
+
+    SECTION("without a zeroed_page_pool") {
+        snw::page_pool pool(allocator);
+        snw::page_cache cache(pool);
+
+        snw::page* page = cache.allocate();
+        memset(page, 0xff, sizeof(*page));
+        cache.deallocate(page);
+
+        page = cache.allocate_zeroed();
+        CHECK(is_zeroed(page));
+        cache.deallocate(page);
+    }
+
+    SECTION("background zeroing") {
+        static constexpr size_t target_size = 2 * snw::page_stack::max_node_size;
+
+        snw::page_pool pool(allocator);
+
+        // dirty every page in the arena
+        {
+            snw::page_cache cache(pool);
+            std::vector<snw::page*> pages;
+            while (snw::page* page = cache.allocate()) {
+                memset(page, 0xff, sizeof(*page));
+                pages.push_back(page);
+            }
+            for (snw::page* page: pages) {
+                cache.deallocate(page);
+            }
+        }
+
+        snw::zeroed_page_pool zeroed_pool(pool, target_size);
+        for (int i = 0; (i < 1000) && (zeroed_pool.size() < target_size); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(zeroed_pool.size() >= target_size);
+
+        {
+            snw::page_cache cache(pool, 2 * snw::page_stack::max_node_size, &zeroed_pool);
+
+            std::vector<snw::page*> pages;
+            for (size_t i = 0; i < (target_size * 2); ++i) {
+                snw::page* page = cache.allocate_zeroed();
+                REQUIRE(page);
+                REQUIRE(is_zeroed(page));
+                memset(page, 0xff, sizeof(*page));
+                pages.push_back(page);
+            }
+            for (snw::page* page: pages) {
+                cache.deallocate(page);
+            }
+        }
+    }
+}
@@ -0,0 +1,165 @@
+#include "catch.hpp"
+#include "broadcast_message_stream.h"
+#include <vector>
+#include <thread>
+#include <memory>
+#include <atomic>
+
+namespace {
+
+struct message {
+    size_t index;
+};
+
+struct counted_message : message {
+    counted_message(size_t index) {
+        this->index = index;
+    }
+};
+
+struct large_message : message {
+    large_message(size_t index) {
+        this->index = index;
+    }
+
+    uint8_t data[1000];
+};
+
+}
+
+TEST_CASE("broadcast_message_stream") {
+    SECTION("every reader sees every message") {
+        snw::broadcast_message_stream<message> stream(4096);
+        snw::broadcast_message_stream<message>::reader reader1(stream);
+        snw::broadcast_message_stream<message>::reader reader2(stream);
+
+        for (size_t i = 0; i < 10; ++i) {
+            stream.write<counted_message>(i);
+        }
+
+        size_t next = 0;
+        CHECK(reader1.read([&](const message& msg) { CHECK(msg.index == next++); }) == 10);
+        next = 0;
+        CHECK(reader2.read([&](const message& msg) { CHECK(msg.index == next++); }, 5) == 5);
+        CHECK(reader2.read([&](const message& msg) { CHECK(msg.index == next++); }) == 5);
+        CHECK(reader1.read([](const message&) {}) == 0);
+
+        // late readers start at the writer's position
+        snw::broadcast_message_stream<message>::reader reader3(stream);
+        CHECK(reader3.read([](const message&) {}) == 0);
+        stream.write<counted_message>(10);
+        CHECK(reader3.read([](const message& msg) { CHECK(msg.index == 10); }) == 1);
+    }
+
+    SECTION("blocking on the slowest reader") {
+        snw::broadcast_message_stream<message> stream(4096);
+        snw::broadcast_message_stream<message>::reader fast(stream);
+        std::unique_ptr<snw::broadcast_message_stream<message>::reader> slow(new snw::broadcast_message_stream<message>::reader(stream));
+
+        size_t written = 0;
+        while (stream.try_write<large_message>(written)) {
+            ++written;
+            fast.read([](const message&) {});
+        }
+        CHECK(written > 0);
+
+        CHECK(slow->read([](const message&) {}, 1) == 1);
+        CHECK(stream.try_write<large_message>(written));
+
+        // readers that go away no longer hold up the writer
+        slow.reset();
+        for (size_t i = 0; i < 100; ++i) {
+            CHECK(stream.try_write<large_message>(written));
+            fast.read([](const message&) {});
+        }
+    }
+
+    SECTION("too many readers") {
+        snw::broadcast_message_stream<message> stream(4096, 1);
+        snw::broadcast_message_stream<message>::reader reader(stream);
+        CHECK_THROWS_AS(snw::broadcast_message_stream<message>::reader(stream), std::runtime_error);
+    }
+
+    SECTION("overwrite") {
+        snw::broadcast_message_stream<message> stream(4096, 16, snw::broadcast_mode::overwrite);
+        snw::broadcast_message_stream<message>::reader reader(stream);
+
+        // the writer never waits...
+        for (size_t i = 0; i < 100; ++i) {
+            stream.write<large_message>(i);
+        }
+
+        // ...so the reader gets lapped and skips to the writer's position
+        CHECK(reader.read([](const message&) {}) == 0);
+        CHECK(reader.overruns() == 1);
+
+        stream.write<large_message>(100);
+        stream.write<large_message>(101);
+        size_t next = 100;
+        CHECK(reader.read([&](const message& msg) { CHECK(msg.index == next++); }) == 2);
+        CHECK(reader.overruns() == 1);
+    }
+
+    SECTION("concurrent readers") {
+        static constexpr size_t reader_count = 3;
+        static constexpr size_t message_count = 100000;
+
+        for (snw::broadcast_mode mode: {snw::broadcast_mode::blocking, snw::broadcast_mode::overwrite}) {
+            snw::broadcast_message_stream<message> stream(4096, reader_count, mode);
+
+            std::vector<std::unique_ptr<snw::broadcast_message_stream<message>::reader>> readers;
+            for (size_t i = 0; i < reader_count; ++i) {
+                readers.emplace_back(new snw::broadcast_message_stream<message>::reader(stream));
+            }
+
+            // messages arrive in order; in overwrite mode some may be skipped
+            std::atomic<bool> writer_done(false);
+            std::vector<size_t> received(reader_count, 0);
+            std::vector<bool> in_order(reader_count, true);
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < reader_count; ++i) {
+                threads.emplace_back([&, i]() {
+                    size_t next = 0;
+                    while (true) {
+                        bool done = writer_done.load();
+                        size_t cnt = readers[i]->read([&](const message& msg) {
+                            if (msg.index < next) {
+                                in_order[i] = false;
+                            }
+                            next = msg.index + 1;
+                            ++received[i];
+                        });
+                        if (cnt == 0) {
+                            if (done) {
+                                break;
+                            }
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+            }
+
+            for (size_t i = 0; i < message_count; ++i) {
+                while (!stream.try_write<counted_message>(i)) {
+                    std::this_thread::yield();
+                }
+            }
+            writer_done = true;
+
+            for (std::thread& thread: threads) {
+                thread.join();
+            }
+
+            for (size_t i = 0; i < reader_count; ++i) {
+                CHECK(in_order[i]);
+                if (mode == snw::broadcast_mode::blocking) {
+                    CHECK(received[i] == message_count);
+                    CHECK(readers[i]->overruns() == 0);
+                }
+                else {
+                    CHECK(received[i] <= message_count);
+                }
+            }
+        }
+    }
+}
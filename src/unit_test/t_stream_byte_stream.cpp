@@ -0,0 +1,173 @@
+#include "catch.hpp"
+#include "byte_stream.h"
+#include <thread>
+#include <cstring>
+
+namespace {
+
+// Variable length records ([len][seq, seq + 1, ...]) so that records
+// straddle the end of the ring, checked byte by byte on the other side.
+void stress(size_t publish_batch) {
+    static constexpr size_t record_count = 200000;
+    static constexpr size_t max_len = 300;
+
+    snw::atomic_byte_stream stream(4096);
+    stream.set_publish_batch(publish_batch);
+
+    std::thread writer([&stream]() {
+        for (size_t seq = 0; seq < record_count; ++seq) {
+            uint16_t len = static_cast<uint16_t>(1 + (seq * 31) % max_len);
+            for (;;) {
+                stream.write_begin();
+
+                void* len_ptr = stream.write<sizeof(len)>();
+                void* ptr = len_ptr ? stream.write(len) : nullptr;
+                if (ptr) {
+                    memcpy(len_ptr, &len, sizeof(len));
+                    for (uint16_t i = 0; i < len; ++i) {
+                        static_cast<uint8_t*>(ptr)[i] = static_cast<uint8_t>(seq + i);
+                    }
+                    stream.write_commit();
+                    break;
+                }
+
+                stream.write_rollback();
+                std::this_thread::yield(); // the tests only get one core
+            }
+        }
+        stream.flush();
+    });
+
+    size_t errors = 0;
+    for (size_t seq = 0; seq < record_count;) {
+        stream.read_begin();
+
+        const void* len_ptr = stream.read<sizeof(uint16_t)>();
+        if (!len_ptr) {
+            stream.read_rollback();
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint16_t len;
+        memcpy(&len, len_ptr, sizeof(len));
+        errors += (len != (1 + (seq * 31) % max_len));
+
+        // a record is only published whole
+        const void* ptr = stream.read(len);
+        if (!ptr) {
+            ++errors;
+            break;
+        }
+
+        for (uint16_t i = 0; i < len; ++i) {
+            errors += (static_cast<const uint8_t*>(ptr)[i] != static_cast<uint8_t>(seq + i));
+        }
+
+        stream.read_commit();
+        ++seq;
+    }
+
+    writer.join();
+
+    CHECK(errors == 0);
+    stream.read_begin();
+    CHECK(stream.readable() == 0);
+}
+
+}
+
+TEST_CASE("byte_stream") {
+    SECTION("write and read") {
+        snw::byte_stream stream(4096);
+
+        stream.write_begin();
+        CHECK(stream.writable() == 4096);
+        memcpy(stream.write(5), "hello", 5);
+        stream.write_commit();
+
+        // rolled back writes aren't seen
+        stream.write_begin();
+        memcpy(stream.write(5), "world", 5);
+        stream.write_rollback();
+
+        stream.read_begin();
+        CHECK(stream.readable() == 5);
+        CHECK(memcmp(stream.read(5), "hello", 5) == 0);
+        CHECK(!stream.read(1));
+
+        // nor are rolled back reads consumed
+        stream.read_rollback();
+        stream.read_begin();
+        CHECK(stream.readable() == 5);
+        CHECK(stream.read(5));
+        stream.read_commit();
+
+        stream.write_begin();
+        CHECK(stream.writable() == 4096);
+    }
+
+    SECTION("publish batch") {
+        snw::byte_stream stream(4096);
+        stream.set_publish_batch(3);
+
+        for (int i = 0; i < 2; ++i) {
+            stream.write_begin();
+            REQUIRE(stream.write<8>());
+            stream.write_commit();
+        }
+
+        stream.read_begin();
+        CHECK(stream.readable() == 0);
+
+        // rolling back doesn't lose the unpublished commits
+        stream.write_begin();
+        REQUIRE(stream.write<8>());
+        stream.write_rollback();
+
+        stream.write_begin();
+        REQUIRE(stream.write<8>());
+        stream.write_commit();
+
+        stream.read_begin();
+        CHECK(stream.readable() == 24);
+
+        stream.write_begin();
+        REQUIRE(stream.write<8>());
+        stream.write_commit();
+
+        stream.read_begin();
+        CHECK(stream.readable() == 24);
+
+        stream.flush();
+        stream.read_begin();
+        CHECK(stream.readable() == 32);
+    }
+
+    SECTION("full stream publishes") {
+        snw::byte_stream stream(4096);
+        stream.set_publish_batch(1000);
+
+        stream.write_begin();
+        REQUIRE(stream.write(4096));
+        stream.write_commit();
+
+        stream.read_begin();
+        CHECK(stream.readable() == 0);
+
+        stream.write_begin();
+        CHECK(!stream.write<8>());
+        stream.write_rollback();
+
+        stream.read_begin();
+        CHECK(stream.readable() == 4096);
+    }
+
+    SECTION("threads") {
+        stress(1);
+    }
+
+    SECTION("threads with a publish batch") {
+        stress(7);
+    }
+}
@@ -0,0 +1,132 @@
+#include "catch.hpp"
+#include "conflating_stream.h"
+#include "varchar.h"
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+struct quote {
+    uint32_t instrument;
+    uint32_t seq;
+    uint64_t price;
+};
+
+}
+
+TEST_CASE("conflating_stream") {
+    SECTION("latest value per key") {
+        snw::conflating_stream<quote> stream(100);
+        CHECK(stream.capacity() == 100);
+        CHECK(stream.read([](const quote&) {}) == 0);
+
+        stream.write(1, quote{1, 0, 100});
+        stream.write(70, quote{70, 0, 200});
+        stream.write(1, quote{1, 1, 101});
+        stream.write(1, quote{1, 2, 102});
+        CHECK(!stream.try_write(100, quote{100, 0, 0}));
+
+        std::vector<quote> quotes;
+        CHECK(stream.read([&](const quote& q) { quotes.push_back(q); }) == 2);
+        REQUIRE(quotes.size() == 2);
+        CHECK(quotes[0].instrument == 1);
+        CHECK(quotes[0].price == 102);
+        CHECK(quotes[1].instrument == 70);
+        CHECK(quotes[1].price == 200);
+
+        // only what changed since
+        CHECK(stream.read([](const quote&) {}) == 0);
+        stream.write(70, quote{70, 1, 201});
+        quotes.clear();
+        CHECK(stream.read([&](const quote& q) { quotes.push_back(q); }) == 1);
+        CHECK(quotes[0].price == 201);
+    }
+
+    SECTION("max_cnt") {
+        snw::conflating_stream<quote> stream(200);
+        for (uint32_t i = 0; i < 200; i += 10) {
+            stream.write(i, quote{i, 0, 0});
+        }
+
+        std::vector<uint32_t> seen;
+        auto handler = [&](const quote& q) { seen.push_back(q.instrument); };
+        CHECK(stream.read(handler, 7) == 7);
+        CHECK(stream.read(handler, 7) == 7);
+        CHECK(stream.read(handler) == 6);
+        CHECK(stream.read(handler) == 0);
+
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < 200; i += 10) {
+            expected.push_back(i);
+        }
+        std::sort(seen.begin(), seen.end());
+        CHECK(seen == expected);
+    }
+
+    SECTION("other integer keys") {
+        snw::conflating_stream<quote, int> stream(10);
+
+        // used as the slot index, not mapped to the next free slot
+        CHECK(stream.try_write(9, quote{9, 0, 900}));
+        CHECK(!stream.try_write(10, quote{10, 0, 0}));
+        CHECK(!stream.try_write(-1, quote{0, 0, 0}));
+
+        snw::conflating_stream<quote, uint32_t> other(10);
+        CHECK(other.try_write(9u, quote{9, 0, 900}));
+        CHECK(!other.try_write(10u, quote{10, 0, 0}));
+    }
+
+    SECTION("varchar keys") {
+        snw::conflating_stream<quote, snw::varchar<16>> stream(2);
+
+        stream.write("AAPL", quote{0, 0, 100});
+        stream.write("MSFT", quote{1, 0, 200});
+        stream.write("AAPL", quote{0, 1, 101});
+        CHECK(!stream.try_write("GOOG", quote{2, 0, 300}));
+
+        uint64_t total = 0;
+        CHECK(stream.read([&](const quote& q) { total += q.price; }) == 2);
+        CHECK(total == 301);
+    }
+
+    SECTION("threads") {
+        static constexpr uint32_t key_count = 16;
+        static constexpr uint32_t update_count = 200000;
+
+        snw::conflating_stream<quote> stream(key_count);
+
+        std::thread writer([&stream]() {
+            for (uint32_t seq = 1; seq <= update_count; ++seq) {
+                uint32_t key = seq % key_count;
+                stream.write(key, quote{key, seq, static_cast<uint64_t>(seq) * 3});
+            }
+        });
+
+        // values are never torn, and never go back in time
+        std::vector<uint32_t> last(key_count, 0);
+        size_t errors = 0;
+        auto handler = [&](const quote& q) {
+            errors += (q.price != (static_cast<uint64_t>(q.seq) * 3));
+            errors += (q.seq <= last[q.instrument]);
+            last[q.instrument] = q.seq;
+        };
+
+        size_t cnt = 0;
+        while (last[update_count % key_count] != update_count) {
+            size_t n = stream.read(handler);
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+            cnt += n;
+        }
+        writer.join();
+        stream.read(handler);
+
+        CHECK(errors == 0);
+        CHECK(cnt <= update_count);
+        for (uint32_t key = 0; key < key_count; ++key) {
+            CHECK(last[key] == (update_count - ((update_count - key) % key_count)));
+        }
+    }
+}
@@ -0,0 +1,165 @@
+#include "catch.hpp"
+#include "elastic_byte_stream.h"
+#include "message_stream.h"
+#include <thread>
+#include <cstring>
+
+namespace {
+
+struct message {
+};
+
+struct counted_message : message {
+    counted_message(size_t index)
+        : index(index)
+    {
+    }
+
+    size_t index;
+    uint8_t payload[200];
+};
+
+}
+
+TEST_CASE("elastic_byte_stream") {
+    SECTION("grows on a burst") {
+        snw::basic_message_stream<message, snw::elastic_byte_stream> stream(4096);
+
+        // far more than the initial ring holds, with nothing read
+        for (size_t i = 0; i < 1000; ++i) {
+            REQUIRE(stream.try_write<counted_message>(i));
+        }
+
+        // one read per ring
+        size_t next = 0;
+        while (stream.read([&](message& msg) {
+            CHECK(static_cast<counted_message&>(msg).index == next++);
+        }) > 0) {
+        }
+        CHECK(next == 1000);
+    }
+
+    SECTION("interleaved reads across rings") {
+        snw::elastic_byte_stream stream(4096);
+        CHECK(stream.capacity() == 4096);
+
+        size_t written = 0;
+        size_t read = 0;
+        for (int round = 0; round < 10; ++round) {
+            for (int i = 0; i < 100; ++i) {
+                stream.write_begin();
+                void* ptr = stream.write(sizeof(written));
+                REQUIRE(ptr);
+                memcpy(ptr, &written, sizeof(written));
+                ++written;
+                stream.write_commit();
+            }
+
+            // read some of it back, leaving the rest behind in older rings
+            stream.read_begin();
+            for (int i = 0; i < 60; ++i) {
+                const void* ptr = stream.read(sizeof(read));
+                if (!ptr) {
+                    stream.read_commit();
+                    stream.read_begin();
+                    ptr = stream.read(sizeof(read));
+                }
+                REQUIRE(ptr);
+
+                size_t value;
+                memcpy(&value, ptr, sizeof(value));
+                REQUIRE(value == read++);
+            }
+            stream.read_commit();
+        }
+        CHECK(stream.capacity() > 4096);
+
+        for (;;) {
+            stream.read_begin();
+            if (stream.readable() == 0) {
+                break;
+            }
+
+            while (const void* ptr = stream.read(sizeof(read))) {
+                size_t value;
+                memcpy(&value, ptr, sizeof(value));
+                REQUIRE(value == read++);
+            }
+            stream.read_commit();
+        }
+        CHECK(read == written);
+    }
+
+    SECTION("grow threshold") {
+        snw::elastic_byte_stream stream(4096, snw::elastic_byte_stream::unlimited, 0.5);
+
+        stream.write_begin();
+        REQUIRE(stream.write(3000));
+        stream.write_commit();
+        CHECK(stream.capacity() == 4096);
+
+        // past the threshold, so the next transaction starts a bigger ring
+        stream.write_begin();
+        CHECK(stream.capacity() == 8192);
+        REQUIRE(stream.write(8));
+        stream.write_commit();
+
+        stream.read_begin();
+        CHECK(stream.read(3000));
+        stream.read_commit();
+
+        stream.read_begin();
+        CHECK(stream.readable() == 8);
+    }
+
+    SECTION("max size") {
+        snw::elastic_byte_stream stream(4096, 8192);
+        CHECK(stream.max_write_size() == 8192);
+        CHECK(snw::elastic_byte_stream(4096, 12000).max_write_size() == 8192);
+
+        stream.write_begin();
+        REQUIRE(stream.write(4096));
+        stream.write_commit();
+
+        stream.write_begin();
+        REQUIRE(stream.write(8192));
+        stream.write_commit();
+        CHECK(stream.capacity() == 8192);
+
+        stream.write_begin();
+        CHECK(!stream.write(1));
+        stream.write_rollback();
+
+        // only the first write of a transaction can grow
+        snw::elastic_byte_stream other(4096);
+        other.write_begin();
+        REQUIRE(other.write(4000));
+        CHECK(!other.write(100));
+        other.write_rollback();
+    }
+
+    SECTION("threads") {
+        static constexpr size_t message_count = 100000;
+
+        snw::basic_message_stream<message, snw::atomic_elastic_byte_stream> stream(4096);
+
+        std::thread writer([&stream]() {
+            for (size_t i = 0; i < message_count; ++i) {
+                stream.write<counted_message>(i);
+            }
+        });
+
+        size_t next = 0;
+        bool in_order = true;
+        while (next < message_count) {
+            if (stream.read([&](message& msg) {
+                in_order = in_order && (static_cast<counted_message&>(msg).index == next++);
+            }) == 0) {
+                std::this_thread::yield();
+            }
+        }
+
+        writer.join();
+        CHECK(in_order);
+    }
+}
@@ -0,0 +1,313 @@
+#include "catch.hpp"
+#include "journal.h"
+#include "journal_replayer.h"
+#include "message_stream.h"
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <chrono>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+
+struct message {
+};
+
+struct counted_message : message {
+    counted_message(uint64_t index)
+        : index(index)
+    {
+    }
+
+    uint64_t index;
+};
+
+struct scribbled_message {
+    scribbled_message(uint64_t index)
+        : index(index)
+    {
+    }
+
+    virtual ~scribbled_message() {
+        index = ~static_cast<uint64_t>(0);
+    }
+
+    uint64_t index;
+};
+
+std::vector<uint8_t> read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// the records of a segment
+std::vector<std::vector<uint8_t>> read_segment(const std::string& path, uint64_t index) {
+    std::vector<uint8_t> data = read_file(path);
+    REQUIRE(data.size() >= sizeof(snw::journal_segment_header));
+
+    snw::journal_segment_header header;
+    memcpy(&header, data.data(), sizeof(header));
+    CHECK(header.magic == snw::journal_segment_header::magic_value);
+    CHECK(header.version == snw::journal_segment_header::version_value);
+    CHECK(header.index == index);
+    CHECK(header.size == data.size());
+
+    std::vector<std::vector<uint8_t>> records;
+    size_t offset = sizeof(header);
+    while ((offset + sizeof(snw::journal_record_header)) <= data.size()) {
+        snw::journal_record_header record;
+        memcpy(&record, &data[offset], sizeof(record));
+        if (record.len == 0) {
+            break;
+        }
+
+        offset += sizeof(record);
+        records.emplace_back(&data[offset], &data[offset] + record.len);
+        offset += (record.len + 7) & ~static_cast<size_t>(7);
+    }
+
+    return records;
+}
+
+}
+
+TEST_CASE("journal") {
+    char directory[] = "/tmp/snw_journal_XXXXXX";
+    REQUIRE(mkdtemp(directory));
+
+    SECTION("append and roll") {
+        {
+            snw::journal_writer journal(directory, 8192);
+            CHECK(journal.segment_index() == 0);
+
+            uint8_t data[1000];
+            for (int i = 0; i < 30; ++i) {
+                memset(data, i, sizeof(data));
+                journal.append(data, 1 + (i * 97) % sizeof(data), i);
+            }
+            CHECK(journal.segment_index() > 0);
+
+            CHECK_THROWS_AS(journal.append(data, 8192), std::runtime_error);
+        }
+
+        std::vector<std::vector<uint8_t>> records;
+        for (uint64_t index = 0; access(snw::journal_segment_path(directory, index).c_str(), F_OK) == 0; ++index) {
+            for (auto& record: read_segment(snw::journal_segment_path(directory, index), index)) {
+                records.push_back(record);
+            }
+        }
+
+        REQUIRE(records.size() == 30);
+        for (int i = 0; i < 30; ++i) {
+            CHECK(records[i].size() == (1 + (i * 97) % 1000));
+            CHECK(records[i][0] == i);
+        }
+
+        // a new writer starts a new segment
+        size_t segment_count = 0;
+        while (access(snw::journal_segment_path(directory, segment_count).c_str(), F_OK) == 0) {
+            ++segment_count;
+        }
+        snw::journal_writer journal(directory, 8192);
+        CHECK(journal.segment_index() == segment_count);
+    }
+
+    SECTION("tee a message_stream") {
+        {
+            snw::journal_writer journal(directory, 64 * 1024);
+            snw::message_stream<message> stream(4096);
+            stream.set_journal(&journal);
+
+            for (uint64_t i = 0; i < 10; ++i) {
+                stream.write<counted_message>(i);
+            }
+            CHECK(stream.read([](message&) {}, 4) == 4);
+
+            // variable length messages are journaled at their committed length
+            snw::span<uint8_t> payload = stream.reserve(100);
+            REQUIRE(payload.size() == 100);
+            counted_message msg(10);
+            memcpy(payload.data(), &msg, sizeof(msg));
+            stream.commit(sizeof(msg));
+
+            // the rest is never read
+        }
+
+        // one record per committed message, holding the framed message
+        std::vector<std::vector<uint8_t>> records = read_segment(snw::journal_segment_path(directory, 0), 0);
+        REQUIRE(records.size() == 11);
+
+        uint64_t next = 0;
+        for (auto& record: records) {
+            REQUIRE(record.size() == (sizeof(size_t) + sizeof(counted_message)));
+
+            size_t len;
+            memcpy(&len, &record[0], sizeof(len));
+            CHECK(len == sizeof(counted_message));
+
+            uint64_t index;
+            memcpy(&index, &record[sizeof(len)], sizeof(index));
+            CHECK(index == next++);
+        }
+        CHECK(next == 11);
+    }
+
+    SECTION("tee messages that are destroyed when read") {
+        {
+            snw::journal_writer journal(directory, 64 * 1024);
+            snw::message_stream<scribbled_message> stream(4096);
+            stream.set_journal(&journal);
+
+            for (uint64_t i = 0; i < 10; ++i) {
+                stream.write<scribbled_message>(i);
+            }
+            CHECK(stream.read([](scribbled_message&) {}) == 10);
+        }
+
+        // copied when they were committed, not after they were destroyed
+        scribbled_message probe(0);
+        size_t index_offset = reinterpret_cast<uint8_t*>(&probe.index) - reinterpret_cast<uint8_t*>(&probe);
+
+        snw::journal_reader reader(directory);
+        snw::journal_record record;
+        uint64_t next = 0;
+        while (reader.next(record)) {
+            uint64_t index;
+            memcpy(&index, record.data.data() + sizeof(size_t) + index_offset, sizeof(index));
+            CHECK(index == next++);
+        }
+        CHECK(next == 10);
+    }
+
+    SECTION("journal failures") {
+        snw::journal_writer journal(directory, 8192);
+        snw::message_stream<message> stream(64 * 1024);
+        stream.set_journal(&journal);
+
+        // a message that can't be journaled isn't written
+        snw::span<uint8_t> payload = stream.reserve(journal.max_record_size() + 1);
+        REQUIRE(payload.size() > 0);
+        CHECK_THROWS_AS(stream.commit(), std::runtime_error);
+        CHECK(stream.read([](message&) {}) == 0);
+
+        // and doesn't get in the way of the next one
+        stream.write<counted_message>(1);
+        CHECK(stream.read([](message&) {}) == 1);
+    }
+
+    SECTION("read back") {
+        {
+            snw::journal_writer journal(directory, 8192);
+            uint8_t data[1000];
+            for (int i = 0; i < 30; ++i) {
+                memset(data, i, sizeof(data));
+                journal.append(data, 1 + (i * 97) % sizeof(data), i);
+            }
+        }
+
+        snw::journal_reader reader(directory);
+        snw::journal_record record;
+        int i = 0;
+        for (; reader.next(record); ++i) {
+            CHECK(record.timestamp == static_cast<uint64_t>(i));
+            REQUIRE(record.data.size() == (1 + (i * 97) % 1000));
+            CHECK(record.data[0] == i);
+            CHECK(record.data[record.data.size() - 1] == i);
+        }
+        CHECK(i == 30);
+        CHECK(!reader.next(record));
+    }
+
+    SECTION("missing journal") {
+        CHECK_THROWS_AS(snw::journal_reader(directory), std::runtime_error);
+    }
+
+    SECTION("replay") {
+        {
+            snw::journal_writer journal(directory, 64 * 1024);
+            snw::message_stream<message> stream(4096);
+            stream.set_journal(&journal);
+
+            for (uint64_t i = 0; i < 100; ++i) {
+                stream.write<counted_message>(i);
+                if ((i % 10) == 9) {
+                    stream.read([](message&) {});
+                }
+            }
+        }
+
+        SECTION("into a handler") {
+            snw::journal_replayer replayer(directory);
+
+            uint64_t next = 0;
+            CHECK(replayer.replay<counted_message>([&](const counted_message& msg) {
+                CHECK(msg.index == next++);
+            }) == 100);
+            CHECK(next == 100);
+        }
+
+        SECTION("into a stream") {
+            snw::journal_replayer replayer(directory);
+            snw::message_stream<message> stream(64 * 1024);
+            CHECK(replayer.replay_into(stream) == 100);
+
+            uint64_t next = 0;
+            CHECK(stream.read([&](message& msg) {
+                CHECK(static_cast<counted_message&>(msg).index == next++);
+            }) == 100);
+        }
+    }
+
+    SECTION("replay into a stream that's too small") {
+        {
+            snw::journal_writer journal(directory, 64 * 1024);
+            std::vector<uint8_t> record(sizeof(size_t) + 8000);
+            size_t len = 8000;
+            memcpy(record.data(), &len, sizeof(len));
+            journal.append(record.data(), record.size());
+        }
+
+        snw::message_stream<message> stream(4096);
+        CHECK(stream.max_message_size() == (4096 - sizeof(size_t)));
+
+        snw::journal_replayer replayer(directory);
+        CHECK_THROWS_AS(replayer.replay_into(stream), std::runtime_error);
+    }
+
+    SECTION("replay timing") {
+        {
+            // batches recorded 20ms apart
+            snw::journal_writer journal(directory, 64 * 1024);
+            uint8_t record[sizeof(size_t) + sizeof(counted_message)];
+            for (uint64_t i = 0; i < 3; ++i) {
+                size_t len = sizeof(counted_message);
+                counted_message msg(i);
+                memcpy(record, &len, sizeof(len));
+                memcpy(record + sizeof(len), &msg, sizeof(msg));
+                journal.append(record, sizeof(record), i * 20000000);
+            }
+        }
+
+        auto replay_time = [&](snw::replay_mode mode, double speed) {
+            snw::journal_replayer replayer(directory, mode, speed);
+            auto start = std::chrono::steady_clock::now();
+            CHECK(replayer.replay_spans([](snw::span<const uint8_t>) {}) == 3);
+            return std::chrono::steady_clock::now() - start;
+        };
+
+        CHECK(replay_time(snw::replay_mode::original_timing, 1.0) >= std::chrono::milliseconds(40));
+        CHECK(replay_time(snw::replay_mode::scaled_timing, 4.0) >= std::chrono::milliseconds(10));
+
+        // no upper bounds, a loaded machine can be arbitrarily late
+        replay_time(snw::replay_mode::max_speed, 1.0);
+
+        CHECK_THROWS_AS(snw::journal_replayer(directory, snw::replay_mode::scaled_timing, 0.0), std::runtime_error);
+    }
+
+    for (uint64_t index = 0; unlink(snw::journal_segment_path(directory, index).c_str()) == 0; ++index) {
+    }
+    rmdir(directory);
+}
@@ -0,0 +1,301 @@
+#include "catch.hpp"
+#include "message_stream.h"
+#include <thread>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct message {
+    virtual ~message() {}
+};
+
+struct counted_message : message {
+    counted_message(size_t index)
+        : index(index)
+    {
+    }
+
+    size_t index;
+};
+
+struct big_message : message {
+    big_message(size_t index)
+        : index(index)
+    {
+    }
+
+    size_t  index;
+    uint8_t payload[1000];
+};
+
+struct destroyed_message : message {
+    destroyed_message(size_t& destroyed)
+        : destroyed(destroyed)
+    {
+    }
+
+    ~destroyed_message() {
+        ++destroyed;
+    }
+
+    size_t& destroyed;
+};
+
+template<typename WaitStrategy>
+void check_wait_read() {
+    static constexpr size_t message_count = 10000;
+
+    snw::basic_message_stream<message, snw::atomic_byte_stream, WaitStrategy> stream(4096);
+
+    std::thread writer([&stream]() {
+        for (size_t i = 0; i < message_count; ++i) {
+            while (!stream.template try_write<counted_message>(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    size_t next = 0;
+    bool in_order = true;
+    while (next < message_count) {
+        size_t cnt = stream.wait_read([&](message& msg) {
+            in_order = in_order && (static_cast<counted_message&>(msg).index == next++);
+        });
+        CHECK(cnt > 0);
+    }
+
+    writer.join();
+    CHECK(in_order);
+}
+
+}
+
+TEST_CASE("message_stream") {
+    SECTION("read and write") {
+        snw::message_stream<message> stream(4096);
+
+        for (size_t i = 0; i < 10; ++i) {
+            stream.write<counted_message>(i);
+        }
+
+        size_t next = 0;
+        CHECK(stream.read([&](message& msg) { CHECK(static_cast<counted_message&>(msg).index == next++); }, 3) == 3);
+        CHECK(stream.read([&](message& msg) { CHECK(static_cast<counted_message&>(msg).index == next++); }) == 7);
+        CHECK(stream.read([](message&) {}) == 0);
+
+        // wait_read returns immediately when there's something to read
+        stream.write<counted_message>(10);
+        CHECK(stream.wait_read([](message&) {}) == 1);
+    }
+
+    SECTION("reserve and commit") {
+        snw::message_stream<message> stream(4096);
+
+        // payloads of any length, including ones that need padding
+        std::vector<std::string> payloads = {"a", "hello", "", "0123456789abcdef", std::string(1000, 'x')};
+        for (const std::string& payload: payloads) {
+            snw::span<uint8_t> buf = stream.reserve(payload.size());
+            REQUIRE(buf);
+            CHECK(buf.size() == payload.size());
+            memcpy(buf.data(), payload.data(), payload.size());
+            stream.commit();
+        }
+
+        // shrink to what was actually written
+        {
+            snw::span<uint8_t> buf = stream.reserve(100);
+            REQUIRE(buf);
+            memcpy(buf.data(), "short", 5);
+            stream.commit(5);
+        }
+
+        // roll back a reservation
+        {
+            snw::span<uint8_t> buf = stream.reserve(100);
+            REQUIRE(buf);
+            stream.rollback();
+        }
+
+        CHECK(!stream.reserve(4096));
+
+        payloads.push_back("short");
+        size_t next = 0;
+        CHECK(stream.read_span([&](snw::span<const uint8_t> buf) {
+            CHECK(std::string(buf.begin(), buf.end()) == payloads[next++]);
+        }) == payloads.size());
+    }
+
+    SECTION("batch") {
+        snw::message_stream<message> stream(4096);
+
+        CHECK(stream.read_batch().empty());
+
+        for (size_t i = 0; i < 10; ++i) {
+            stream.write<counted_message>(i);
+        }
+
+        auto batch = stream.read_batch();
+        CHECK(!batch.empty());
+
+        // written after the batch was taken, so not in it
+        stream.write<counted_message>(10);
+
+        size_t next = 0;
+        auto it = batch.begin();
+        for (; next < 10; ++it) {
+            REQUIRE(it != batch.end());
+            CHECK(static_cast<counted_message&>(*it).index == next++);
+            CHECK(it.payload().size() == sizeof(counted_message));
+        }
+        CHECK(it == batch.end());
+
+        stream.commit_batch(batch);
+
+        // the batch freed its space, and the rest is still there
+        CHECK(stream.reserve(4096 - 2 * (sizeof(size_t) + sizeof(counted_message))));
+        stream.rollback();
+        CHECK(stream.read([&](message& msg) { CHECK(static_cast<counted_message&>(msg).index == next++); }) == 1);
+    }
+
+    SECTION("batch payloads") {
+        struct raw {
+        };
+        snw::message_stream<raw> stream(4096);
+
+        std::vector<std::string> payloads = {"a", "hello", "", std::string(100, 'x')};
+        for (const std::string& payload: payloads) {
+            snw::span<uint8_t> buf = stream.reserve(payload.size());
+            REQUIRE(buf);
+            memcpy(buf.data(), payload.data(), payload.size());
+            stream.commit();
+        }
+
+        auto batch = stream.read_batch();
+        size_t next = 0;
+        for (auto it = batch.begin(); it != batch.end(); ++it) {
+            REQUIRE(next < payloads.size());
+            CHECK(std::string(it.payload().begin(), it.payload().end()) == payloads[next++]);
+        }
+        CHECK(next == payloads.size());
+        stream.commit_batch(batch);
+
+        CHECK(stream.read_batch().empty());
+    }
+
+    SECTION("batch destroys messages") {
+        snw::message_stream<message> stream(4096);
+
+        size_t destroyed = 0;
+        for (size_t i = 0; i < 5; ++i) {
+            stream.write<destroyed_message>(destroyed);
+        }
+
+        auto batch = stream.read_batch();
+        CHECK(std::distance(batch.begin(), batch.end()) == 5);
+        CHECK(destroyed == 0);
+
+        stream.commit_batch(batch);
+        CHECK(destroyed == 5);
+    }
+
+    SECTION("spin_wait") {
+        check_wait_read<snw::spin_wait>();
+    }
+
+    SECTION("yield_wait") {
+        check_wait_read<snw::yield_wait>();
+    }
+
+    SECTION("futex_wait") {
+        check_wait_read<snw::futex_wait>();
+
+        // the reader falls asleep before the writer shows up
+        snw::basic_message_stream<message, snw::atomic_byte_stream, snw::futex_wait> stream(4096);
+        std::thread writer([&stream]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            stream.write<counted_message>(42);
+        });
+
+        size_t index = 0;
+        CHECK(stream.wait_read([&](message& msg) { index = static_cast<counted_message&>(msg).index; }) == 1);
+        CHECK(index == 42);
+
+        writer.join();
+    }
+
+    SECTION("futex_wait with a publish batch") {
+        static constexpr size_t round_count = 2000;
+
+        // Bursts that are mostly published by flush, with the reader going
+        // to sleep in between. A missed wakeup hangs the test.
+        snw::basic_message_stream<message, snw::atomic_byte_stream, snw::futex_wait> stream(4096);
+        stream.set_publish_batch(8);
+
+        size_t message_count = 0;
+        for (size_t round = 0; round < round_count; ++round) {
+            message_count += 1 + (round % 13);
+        }
+
+        std::thread writer([&stream]() {
+            size_t index = 0;
+            for (size_t round = 0; round < round_count; ++round) {
+                for (size_t i = 0; i < (1 + (round % 13)); ++i) {
+                    while (!stream.try_write<counted_message>(index)) {
+                        std::this_thread::yield();
+                    }
+                    ++index;
+                }
+                stream.flush();
+
+                if ((round % 8) == 0) {
+                    std::this_thread::yield(); // let the reader fall asleep
+                }
+            }
+        });
+
+        size_t next = 0;
+        bool in_order = true;
+        while (next < message_count) {
+            stream.wait_read([&](message& msg) {
+                in_order = in_order && (static_cast<counted_message&>(msg).index == next++);
+            });
+        }
+
+        writer.join();
+        CHECK(in_order);
+        CHECK(next == message_count);
+    }
+
+    SECTION("futex_wait when a publish batch fills the ring") {
+        static constexpr size_t message_count = 1000;
+
+        // The ring fills up long before a batch is published, so it's only
+        // ever published by the writes that don't fit, while the reader is
+        // asleep. A missed wakeup hangs the test.
+        snw::basic_message_stream<message, snw::atomic_byte_stream, snw::futex_wait> stream(4096);
+        stream.set_publish_batch(16);
+
+        std::thread writer([&stream]() {
+            for (size_t i = 0; i < message_count; ++i) {
+                while (!stream.try_write<big_message>(i)) {
+                    std::this_thread::yield();
+                }
+            }
+            stream.flush();
+        });
+
+        size_t next = 0;
+        bool in_order = true;
+        while (next < message_count) {
+            stream.wait_read([&](message& msg) {
+                in_order = in_order && (static_cast<big_message&>(msg).index == next++);
+            });
+        }
+
+        writer.join();
+        CHECK(in_order);
+        CHECK(next == message_count);
+    }
+}
@@ -0,0 +1,105 @@
+#include "catch.hpp"
+#include "mpsc_message_stream.h"
+#include <vector>
+#include <thread>
+
+namespace {
+
+struct message {
+    virtual ~message() {}
+};
+
+struct counted_message : message {
+    counted_message(int producer, size_t index)
+        : producer(producer)
+        , index(index)
+    {
+    }
+
+    int    producer;
+    size_t index;
+};
+
+}
+
+TEST_CASE("mpsc_message_stream") {
+    SECTION("reservation order") {
+        snw::mpsc_message_stream<message> stream(4096);
+
+        for (size_t i = 0; i < 10; ++i) {
+            stream.write<counted_message>(0, i);
+        }
+
+        size_t next = 0;
+        size_t cnt = stream.read([&](message& msg) {
+            CHECK(static_cast<counted_message&>(msg).index == next++);
+        }, 4);
+        CHECK(cnt == 4);
+
+        cnt = stream.read([&](message& msg) {
+            CHECK(static_cast<counted_message&>(msg).index == next++);
+        });
+        CHECK(cnt == 6);
+        CHECK(stream.read([](message&) {}) == 0);
+    }
+
+    SECTION("full") {
+        snw::mpsc_message_stream<message> stream(4096);
+
+        size_t written = 0;
+        while (stream.try_write<counted_message>(0, written)) {
+            ++written;
+        }
+        CHECK(written > 0);
+        CHECK_THROWS_AS(stream.write<counted_message>(0, 0), std::runtime_error);
+
+        // the space is reusable once it has been read
+        CHECK(stream.read([](message&) {}, 1) == 1);
+        CHECK(stream.try_write<counted_message>(0, written));
+        CHECK(stream.read([](message&) {}) == written);
+    }
+
+    SECTION("multiple producers") {
+        static constexpr int producer_count = 4;
+        static constexpr size_t message_count = 100000;
+
+        snw::mpsc_message_stream<message> stream(4096);
+
+        std::vector<std::thread> producers;
+        for (int producer = 0; producer < producer_count; ++producer) {
+            producers.emplace_back([&stream, producer]() {
+                for (size_t i = 0; i < message_count; ++i) {
+                    while (!stream.try_write<counted_message>(producer, i)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        // each producer's messages must arrive in order
+        std::vector<size_t> next(producer_count, 0);
+        size_t total = 0;
+        bool in_order = true;
+        while (total < (producer_count * message_count)) {
+            size_t cnt = stream.read([&](message& msg) {
+                auto& counted = static_cast<counted_message&>(msg);
+                in_order = in_order && (counted.index == next[counted.producer]);
+                next[counted.producer] = counted.index + 1;
+            });
+            if (cnt == 0) {
+                std::this_thread::yield();
+            }
+
+            total += cnt;
+        }
+
+        for (std::thread& producer: producers) {
+            producer.join();
+        }
+
+        CHECK(in_order);
+        for (size_t count: next) {
+            CHECK(count == message_count);
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#include "catch.hpp"
+#include "pod_stream.h"
+#include <vector>
+#include <thread>
+
+namespace {
+
+struct tick {
+    uint64_t seq;
+    uint32_t instrument;
+    uint32_t price;
+};
+
+// not a power of 2, so items straddle the end of the ring
+struct odd_tick {
+    uint64_t seq;
+    uint64_t values[2];
+};
+
+}
+
+TEST_CASE("pod_stream") {
+    SECTION("single items") {
+        snw::pod_stream<tick> stream(256);
+        CHECK(stream.capacity() >= 256);
+
+        tick in = {1, 2, 3};
+        CHECK(stream.try_write(in));
+
+        tick out = {};
+        CHECK(stream.try_read(out));
+        CHECK(out.seq == 1);
+        CHECK(out.instrument == 2);
+        CHECK(out.price == 3);
+        CHECK(!stream.try_read(out));
+    }
+
+    SECTION("bulk") {
+        snw::pod_stream<odd_tick> stream(100);
+        const size_t capacity = stream.capacity();
+
+        std::vector<odd_tick> in(capacity + 10);
+        for (size_t i = 0; i < in.size(); ++i) {
+            in[i].seq = i;
+        }
+
+        // only what fits is written
+        CHECK(stream.write_n(in.data(), in.size()) == capacity);
+        CHECK(!stream.try_write(in[0]));
+
+        std::vector<odd_tick> out(in.size());
+        CHECK(stream.read_n(out.data(), 7) == 7);
+        CHECK(stream.write_n(in.data() + capacity, 10) == 7);
+
+        // the rest comes out in order, across the end of the ring
+        size_t next = 7;
+        CHECK(stream.read([&](const odd_tick& item) { CHECK(item.seq == next++); }, 5) == 5);
+        CHECK(stream.read_n(out.data(), out.size()) == (capacity - 5));
+        for (size_t i = 0; i < (capacity - 5); ++i) {
+            REQUIRE(out[i].seq == (i + 12));
+        }
+        CHECK(stream.read([](const odd_tick&) {}) == 0);
+    }
+
+    SECTION("threads") {
+        static constexpr uint64_t count = 1000000;
+
+        snw::atomic_pod_stream<tick> stream(1024);
+
+        std::thread writer([&stream]() {
+            tick batch[32];
+            for (uint64_t i = 0; i < count;) {
+                size_t n = 0;
+                for (; (n < 32) && ((i + n) < count); ++n) {
+                    batch[n].seq = i + n;
+                }
+
+                size_t written = 0;
+                while (written < n) {
+                    written += stream.write_n(batch + written, n - written);
+                    if (written < n) {
+                        std::this_thread::yield();
+                    }
+                }
+                i += n;
+            }
+        });
+
+        uint64_t next = 0;
+        bool in_order = true;
+        while (next < count) {
+            if (stream.read([&](const tick& item) { in_order = in_order && (item.seq == next++); }) == 0) {
+                std::this_thread::yield();
+            }
+        }
+
+        writer.join();
+        CHECK(in_order);
+    }
+}
@@ -0,0 +1,191 @@
+#include "catch.hpp"
+#include "shared_byte_stream.h"
+#include "message_stream.h"
+#include "platform.h"
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/wait.h>
+
+namespace {
+
+// no vtable, since the reader is another process
+struct tick {
+    tick(uint64_t index)
+        : index(index)
+    {
+        memset(payload, static_cast<int>(index), sizeof(payload));
+    }
+
+    uint64_t index;
+    uint8_t  payload[40];
+};
+
+void make_name(char (&name)[64]) {
+    snprintf(name, sizeof(name), "/t_shared_byte_stream_%d", static_cast<int>(snw::get_current_process_id()));
+}
+
+}
+
+TEST_CASE("shared_byte_stream") {
+    char name[64];
+    make_name(name);
+
+    SECTION("create and attach") {
+        snw::shared_byte_stream writer = snw::shared_byte_stream::create(name, 4096);
+        CHECK(writer);
+        CHECK(writer.size() == 4096);
+        CHECK_THROWS_AS(snw::shared_byte_stream::create(name, 4096), std::runtime_error);
+
+        snw::shared_byte_stream reader = snw::shared_byte_stream::attach(name);
+        CHECK(reader.size() == writer.size());
+
+        // wrap around a few times to exercise the mirrored mapping
+        for (uint64_t i = 0; i < 10000; ++i) {
+            writer.write_begin();
+            void* wptr = writer.write(sizeof(uint64_t) * 3);
+            REQUIRE(wptr);
+            uint64_t values[3] = {i, i + 1, i + 2};
+            memcpy(wptr, values, sizeof(values));
+            writer.write_commit();
+
+            reader.read_begin();
+            const void* rptr = reader.read(sizeof(values));
+            REQUIRE(rptr);
+            REQUIRE(memcmp(rptr, values, sizeof(values)) == 0);
+            CHECK(!reader.read(1));
+            reader.read_commit();
+        }
+
+        // the creator owns the name
+        writer.close();
+        CHECK(!writer);
+        CHECK_THROWS_AS(snw::shared_byte_stream::attach(name), std::runtime_error);
+    }
+
+    SECTION("full") {
+        snw::shared_byte_stream writer = snw::shared_byte_stream::create(name, 4096);
+        snw::shared_byte_stream reader = snw::shared_byte_stream::attach(name);
+
+        writer.write_begin();
+        CHECK(writer.write(4096));
+        CHECK(!writer.write(1));
+        writer.write_commit();
+
+        reader.read_begin();
+        CHECK(reader.read(100));
+        reader.read_commit();
+
+        writer.write_begin();
+        CHECK(writer.write(100));
+        CHECK(!writer.write(1));
+        writer.write_rollback();
+        CHECK(writer.writable() == 100);
+    }
+
+    SECTION("across processes") {
+        static constexpr uint64_t count = 100000;
+
+        snw::shared_byte_stream writer = snw::shared_byte_stream::create(name, 4096);
+
+        pid_t pid = fork();
+        REQUIRE(pid >= 0);
+        if (pid == 0) {
+            // the child must never return into the test runner
+            int result = 1;
+            try {
+                snw::shared_byte_stream reader = snw::shared_byte_stream::attach(name);
+
+                uint64_t expected = 0;
+                while (expected < count) {
+                    reader.read_begin();
+                    if (reader.readable() == 0) {
+                        sched_yield();
+                        continue;
+                    }
+
+                    while (const void* ptr = reader.read(sizeof(uint64_t))) {
+                        uint64_t value;
+                        memcpy(&value, ptr, sizeof(value));
+                        if (value != expected++) {
+                            _exit(2);
+                        }
+                    }
+                    reader.read_commit();
+                }
+
+                result = 0;
+            }
+            catch (...) {
+            }
+            _exit(result);
+        }
+
+        for (uint64_t i = 0; i < count;) {
+            writer.write_begin();
+            if (writer.writable() < sizeof(uint64_t)) {
+                sched_yield();
+                continue;
+            }
+
+            while (void* ptr = writer.write(sizeof(uint64_t))) {
+                memcpy(ptr, &i, sizeof(i));
+                if (++i == count) {
+                    break;
+                }
+            }
+            writer.write_commit();
+        }
+
+        int status = 0;
+        REQUIRE(waitpid(pid, &status, 0) == pid);
+        CHECK(WIFEXITED(status));
+        CHECK(WEXITSTATUS(status) == 0);
+    }
+
+    SECTION("messages across processes") {
+        static constexpr uint64_t count = 100000;
+
+        using tick_stream = snw::basic_message_stream<tick, snw::shared_byte_stream, snw::yield_wait>;
+        tick_stream writer(snw::shared_byte_stream::create(name, 4096));
+        writer.set_publish_batch(8);
+
+        pid_t pid = fork();
+        REQUIRE(pid >= 0);
+        if (pid == 0) {
+            // the child must never return into the test runner
+            int result = 1;
+            try {
+                tick_stream reader(snw::shared_byte_stream::attach(name));
+
+                uint64_t expected = 0;
+                bool ok = true;
+                while (ok && (expected < count)) {
+                    reader.wait_read([&](tick& msg) {
+                        ok = ok && (msg.index == expected) && (msg.payload[39] == static_cast<uint8_t>(expected));
+                        ++expected;
+                    });
+                }
+
+                result = ok ? 0 : 2;
+            }
+            catch (...) {
+            }
+            _exit(result);
+        }
+
+        for (uint64_t i = 0; i < count; ++i) {
+            while (!writer.try_write<tick>(i)) {
+                sched_yield();
+            }
+        }
+        writer.flush();
+
+        int status = 0;
+        REQUIRE(waitpid(pid, &status, 0) == pid);
+        CHECK(WIFEXITED(status));
+        CHECK(WEXITSTATUS(status) == 0);
+    }
+}
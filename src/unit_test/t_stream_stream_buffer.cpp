@@ -1,6 +1,8 @@
 #include "catch.hpp"
 #include "stream_buffer.h"
+#include "stream_buffer_pool.h"
 #include <cstring>
+#include <vector>
 
 TEST_CASE("stream_buffer") {
     SECTION("construction and assignment") {
@@ -57,4 +59,84 @@ TEST_CASE("stream_buffer") {
         CHECK(memcmp(lower_data + sb.size() - 4, lower_data, 4) == 0);
         CHECK(memcmp(upper_data + sb.size() - 4, upper_data, 4) == 0);
     }
+
+    SECTION("many buffers on one thread") {
+        std::vector<snw::stream_buffer> buffers;
+        for (int i = 0; i < 16; ++i) {
+            buffers.emplace_back(4096);
+            CHECK(buffers.back());
+        }
+    }
+    SECTION("prefault") {
+        for (snw::prefault_mode mode: {snw::prefault_mode::none, snw::prefault_mode::populate, snw::prefault_mode::lock}) {
+            snw::stream_buffer sb(64 * 1024, mode);
+            CHECK(sb);
+
+            // fresh buffers read as zero without being cleared
+            bool zeroed = true;
+            for (size_t i = 0; i < (sb.size() * 2); ++i) {
+                zeroed = zeroed && (sb.data()[i] == 0);
+            }
+            CHECK(zeroed);
+
+            sb.data()[0] = 1;
+            CHECK(sb.data()[sb.size()] == 1);
+        }
+    }
+    SECTION("huge pages") {
+        // falls back to regular pages if no huge pages are reserved
+        snw::stream_buffer sb(4096, snw::prefault_mode::none, true);
+        CHECK(sb);
+        if (sb.huge_pages()) {
+            CHECK(sb.size() >= (2 * 1024 * 1024));
+        }
+        else {
+            CHECK(sb.size() == 4096);
+        }
+
+        sb.data()[sb.size() - 1] = 1;
+        CHECK(sb.data()[(sb.size() * 2) - 1] == 1);
+    }
+    SECTION("pooling") {
+        snw::stream_buffer_pool& pool = snw::stream_buffer_pool::instance();
+        pool.clear();
+
+        uint8_t* data;
+        {
+            snw::stream_buffer sb(128 * 1024);
+            data = sb.data();
+            memset(data, 0xff, sb.size());
+        }
+        CHECK(pool.size() == (128 * 1024));
+
+        // the same mapping comes back, zeroed
+        size_t hits = pool.hits();
+        {
+            snw::stream_buffer sb(100 * 1024);
+            CHECK(sb.data() == data);
+            CHECK(pool.hits() == (hits + 1));
+            CHECK(pool.size() == 0);
+
+            bool zeroed = true;
+            for (size_t i = 0; i < (sb.size() * 2); ++i) {
+                zeroed = zeroed && (sb.data()[i] == 0);
+            }
+            CHECK(zeroed);
+
+            // different sizes don't share
+            snw::stream_buffer other(4096);
+            CHECK(pool.hits() == (hits + 1));
+        }
+        CHECK(pool.size() == ((128 * 1024) + 4096));
+
+        // nothing is kept when the pool is turned off
+        pool.set_capacity(0);
+        CHECK(pool.size() == 0);
+        {
+            snw::stream_buffer sb(4096);
+        }
+        CHECK(pool.size() == 0);
+
+        pool.set_capacity(snw::stream_buffer_pool::default_capacity);
+    }
 }
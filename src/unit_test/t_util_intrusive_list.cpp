@@ -240,3 +240,47 @@ TEST_CASE("erase") {
         CHECK(equals(l, {1, 2}));
     }
 }
+
+TEST_CASE("splice") {
+    node n1(1);
+    node n2(2);
+    node n3(3);
+    node n4(4);
+
+    {
+        list l1;
+        list l2;
+        l1.push_back(n1);
+        l1.push_back(n4);
+        l2.push_back(n2);
+        l2.push_back(n3);
+
+        l1.splice(++l1.begin(), l2);
+        CHECK(equals(l1, {1, 2, 3, 4}));
+        CHECK(l2.empty());
+
+        // splicing an empty list is a no-op
+        l1.splice(l1.end(), l2);
+        CHECK(equals(l1, {1, 2, 3, 4}));
+        CHECK(l2.empty());
+
+        l2.splice(l2.end(), l1);
+        CHECK(equals(l2, {1, 2, 3, 4}));
+        CHECK(l1.empty());
+    }
+    {
+        list l1;
+        list l2;
+        l1.push_back(n3);
+        l2.push_back(n1);
+        l2.push_back(n2);
+
+        l1.splice(l1.begin(), l2);
+        CHECK(equals(l1, {1, 2, 3}));
+
+        l2.push_back(n4);
+        l1.splice(l1.end(), l2);
+        CHECK(equals(l1, {1, 2, 3, 4}));
+        CHECK(l2.empty());
+    }
+}
@@ -0,0 +1,41 @@
+#include "catch.hpp"
+#include "span.h"
+#include <numeric>
+
+TEST_CASE("span") {
+    SECTION("construction") {
+        snw::span<int> empty;
+        CHECK(!empty);
+        CHECK(empty.empty());
+        CHECK(empty.size() == 0);
+        CHECK(empty.begin() == empty.end());
+
+        int values[4] = {1, 2, 3, 4};
+        snw::span<int> s1(values, 4);
+        snw::span<int> s2(values, values + 4);
+        CHECK(s1);
+        CHECK(s1.size() == 4);
+        CHECK(s2.data() == s1.data());
+        CHECK(s2.size() == s1.size());
+
+        snw::span<const int> s3(s1);
+        CHECK(s3.data() == values);
+        CHECK(s3.size() == 4);
+    }
+
+    SECTION("access") {
+        int values[4] = {1, 2, 3, 4};
+        snw::span<int> s(values, 4);
+
+        CHECK(std::accumulate(s.begin(), s.end(), 0) == 10);
+
+        s[2] = 30;
+        CHECK(values[2] == 30);
+
+        snw::span<int> sub = s.subspan(1, 2);
+        CHECK(sub.size() == 2);
+        CHECK(sub[0] == 2);
+        CHECK(sub[1] == 30);
+        CHECK(s.subspan(4, 0).empty());
+    }
+}